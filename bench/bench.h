@@ -0,0 +1,94 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_BENCH_H_
+#define ENCODING_BINARY_BENCH_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+
+#if defined(__i386__) || defined(__x86_64__)
+#  include <x86intrin.h>
+#else
+#  include <chrono>
+#endif
+
+/**
+ * @file
+ * @brief Tiny timing harness shared by benchmarks.
+ *
+ * Timings are reported in TSC cycles on x86 and in nanoseconds
+ * elsewhere. Each measurement is the best of several trials.
+ */
+namespace bench {
+
+#if defined(__i386__) || defined(__x86_64__)
+inline uint64_t now() { return __rdtsc(); }
+inline const char * unit() { return "cycles"; }
+#else
+inline uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline const char * unit() { return "ns"; }
+#endif
+
+/**
+ * @brief Prevents the compiler from discarding a computed value.
+ */
+template <typename T>
+inline void keep(T const &value)
+{
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+/**
+ * @brief Runs `fn` `trials` times and returns the best time per
+ * `units` items processed by one run.
+ */
+template <typename Fn>
+double measure(Fn fn, std::size_t units, int trials = 50)
+{
+    uint64_t best = ~uint64_t(0);
+    for (int i = 0; i < trials; ++i) {
+        const uint64_t start = now();
+        fn();
+        const uint64_t elapsed = now() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return double(best) / double(units);
+}
+
+}
+
+#endif /* ENCODING_BINARY_BENCH_H_ */
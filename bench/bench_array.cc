@@ -0,0 +1,125 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares encoding and decoding an array one value at a time with
+// the bulk put_array/get_array operations, for every instruction set
+// level the running CPU supports.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_array.cc -o bench_array
+
+#include "bench.h"
+#include "encoding/binary/buffer.h"
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+const std::size_t Values = 1 << 20;
+
+template <typename ByteOrder, typename T>
+struct put_each {
+    uint8_t *dst;
+    const T *src;
+    void operator()() const {
+        bin::basic_buffer<ByteOrder, bin::write_access_tag> buf(dst, Values * sizeof(T));
+        for (std::size_t i = 0; i < Values; ++i) buf.put(src[i]);
+        bench::keep(dst[0]);
+    }
+};
+
+template <typename ByteOrder, typename T>
+struct put_all {
+    uint8_t *dst;
+    const T *src;
+    void operator()() const {
+        bin::basic_buffer<ByteOrder, bin::write_access_tag> buf(dst, Values * sizeof(T));
+        buf.put_array(src, Values);
+        bench::keep(dst[0]);
+    }
+};
+
+template <typename ByteOrder, typename T>
+struct get_each {
+    const uint8_t *src;
+    T *dst;
+    void operator()() const {
+        bin::basic_buffer<ByteOrder, bin::read_access_tag> buf(src, Values * sizeof(T));
+        for (std::size_t i = 0; i < Values; ++i) buf.get(dst[i]);
+        bench::keep(dst[0]);
+    }
+};
+
+template <typename ByteOrder, typename T>
+struct get_all {
+    const uint8_t *src;
+    T *dst;
+    void operator()() const {
+        bin::basic_buffer<ByteOrder, bin::read_access_tag> buf(src, Values * sizeof(T));
+        buf.get_array(dst, Values);
+        bench::keep(dst[0]);
+    }
+};
+
+template <typename ByteOrder, typename T>
+void run(const char *type_name, const char *order_name)
+{
+    std::vector<T> values(Values);
+    for (std::size_t i = 0; i < Values; ++i) values[i] = T(i * 2654435761u);
+    std::vector<uint8_t> bytes(Values * sizeof(T) + 1);
+    uint8_t *wire = &bytes[1];
+
+    put_each<ByteOrder, T> pe = {wire, &values[0]};
+    put_all<ByteOrder, T> pa = {wire, &values[0]};
+    get_each<ByteOrder, T> ge = {wire, &values[0]};
+    get_all<ByteOrder, T> ga = {wire, &values[0]};
+    std::printf("%-8s %-14s %-4s %10.3f %10.3f\n", type_name, order_name, "put",
+                bench::measure(pe, Values, 10), bench::measure(pa, Values, 10));
+    std::printf("%-8s %-14s %-4s %10.3f %10.3f\n", type_name, order_name, "get",
+                bench::measure(ge, Values, 10), bench::measure(ga, Values, 10));
+}
+
+}
+
+int main()
+{
+    std::printf("%s per value, %lu values\n", bench::unit(), static_cast<unsigned long>(Values));
+    const bin::cpu_level detected = bin::detected_cpu_level();
+    for (int level = bin::cpu_level_scalar; level <= detected; ++level) {
+        bin::force_cpu_level(bin::cpu_level(level));
+        std::printf("\nkernels: %s\n", bin::cpu_level_name(bin::active_cpu_level()));
+        std::printf("%-8s %-14s %-4s %10s %10s\n", "type", "order", "op", "scalar", "array");
+        run<bin::big_endian, uint16_t>("uint16", "big_endian");
+        run<bin::big_endian, uint32_t>("uint32", "big_endian");
+        run<bin::big_endian, uint64_t>("uint64", "big_endian");
+        run<bin::native_endian, uint32_t>("uint32", "native_endian");
+    }
+    return 0;
+}
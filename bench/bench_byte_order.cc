@@ -0,0 +1,198 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares the byte-at-a-time shift-and-or codecs the library used
+// to ship with the current load-plus-bswap strategies.
+//
+// Build with optimizations and aligned loops, e.g.:
+//   g++ -O2 -falign-loops=64 -Iinclude bench/bench_byte_order.cc -o bench_byte_order
+
+#include "bench.h"
+#include "encoding/binary/buffer.h"
+#include <algorithm>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace legacy {
+
+struct big_endian {
+    static void encode(uint16_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val >> 8);
+        buf[1] = uint8_t(val);
+    }
+    static void decode(const uint8_t *buf, uint16_t &val) {
+        val = uint16_t(buf[0] << 8) | buf[1];
+    }
+    static void encode(uint32_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val >> 24);
+        buf[1] = uint8_t(val >> 16);
+        buf[2] = uint8_t(val >> 8);
+        buf[3] = uint8_t(val);
+    }
+    static void decode(const uint8_t *buf, uint32_t &val) {
+        val = uint32_t(buf[0]) << 24 | uint32_t(buf[1]) << 16 |
+            uint32_t(buf[2]) << 8 | buf[3];
+    }
+    static void encode(uint64_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val >> 56);
+        buf[1] = uint8_t(val >> 48);
+        buf[2] = uint8_t(val >> 40);
+        buf[3] = uint8_t(val >> 32);
+        buf[4] = uint8_t(val >> 24);
+        buf[5] = uint8_t(val >> 16);
+        buf[6] = uint8_t(val >> 8);
+        buf[7] = uint8_t(val);
+    }
+    static void decode(const uint8_t *buf, uint64_t &val) {
+        val = uint64_t(buf[0]) << 56 | uint64_t(buf[1]) << 48 |
+            uint64_t(buf[2]) << 40 | uint64_t(buf[3]) << 32 |
+            uint64_t(buf[4]) << 24 | uint64_t(buf[5]) << 16 |
+            uint64_t(buf[6]) << 8 | buf[7];
+    }
+};
+
+struct little_endian {
+    static void encode(uint16_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val);
+        buf[1] = uint8_t(val >> 8);
+    }
+    static void decode(const uint8_t *buf, uint16_t &val) {
+        val = uint16_t(buf[1] << 8) | buf[0];
+    }
+    static void encode(uint32_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val);
+        buf[1] = uint8_t(val >> 8);
+        buf[2] = uint8_t(val >> 16);
+        buf[3] = uint8_t(val >> 24);
+    }
+    static void decode(const uint8_t *buf, uint32_t &val) {
+        val = uint32_t(buf[3]) << 24 | uint32_t(buf[2]) << 16 |
+            uint32_t(buf[1]) << 8 | buf[0];
+    }
+    static void encode(uint64_t val, uint8_t *buf) {
+        buf[0] = uint8_t(val);
+        buf[1] = uint8_t(val >> 8);
+        buf[2] = uint8_t(val >> 16);
+        buf[3] = uint8_t(val >> 24);
+        buf[4] = uint8_t(val >> 32);
+        buf[5] = uint8_t(val >> 40);
+        buf[6] = uint8_t(val >> 48);
+        buf[7] = uint8_t(val >> 56);
+    }
+    static void decode(const uint8_t *buf, uint64_t &val) {
+        val = uint64_t(buf[7]) << 56 | uint64_t(buf[6]) << 48 |
+            uint64_t(buf[5]) << 40 | uint64_t(buf[4]) << 32 |
+            uint64_t(buf[3]) << 24 | uint64_t(buf[2]) << 16 |
+            uint64_t(buf[1]) << 8 | buf[0];
+    }
+};
+
+}
+
+namespace {
+
+const std::size_t Values = 4096;
+
+// Loops are kept out of line so every variant gets its own, equally
+// aligned copy instead of whatever placement inlining into main gives.
+template <typename Order, typename T>
+__attribute__((noinline)) T decode_all(const uint8_t *src)
+{
+    T acc = 0;
+    for (std::size_t i = 0; i < Values; ++i) {
+        T val;
+        Order::decode(src + i * sizeof(T), val);
+        acc ^= val;
+    }
+    return acc;
+}
+
+template <typename Order, typename T>
+__attribute__((noinline)) void encode_all(uint8_t *dst)
+{
+    for (std::size_t i = 0; i < Values; ++i) {
+        Order::encode(T(i * 0x9e3779b97f4a7c15u), dst + i * sizeof(T));
+    }
+}
+
+template <typename Order, typename T>
+struct decode_loop {
+    const uint8_t *src;
+    void operator()() const { bench::keep(decode_all<Order, T>(src)); }
+};
+
+template <typename Order, typename T>
+struct encode_loop {
+    uint8_t *dst;
+    void operator()() const {
+        encode_all<Order, T>(dst);
+        bench::keep(dst[0]);
+    }
+};
+
+// Interleaves trials of all four loops, so a burst of noise on a busy
+// machine doesn't favour one of them.
+template <typename Legacy, typename Current, typename T>
+void run(const char *type_name, const char *order_name, uint8_t *buf)
+{
+    decode_loop<Legacy, T> old_dec = {buf};
+    decode_loop<Current, T> new_dec = {buf};
+    encode_loop<Legacy, T> old_enc = {buf};
+    encode_loop<Current, T> new_enc = {buf};
+    double best[4] = {1e30, 1e30, 1e30, 1e30};
+    for (int round = 0; round < 20; ++round) {
+        best[0] = std::min(best[0], bench::measure(old_dec, Values));
+        best[1] = std::min(best[1], bench::measure(new_dec, Values));
+        best[2] = std::min(best[2], bench::measure(old_enc, Values));
+        best[3] = std::min(best[3], bench::measure(new_enc, Values));
+    }
+    std::printf("%-8s %-13s %-6s %10.3f %10.3f\n", type_name, order_name, "decode", best[0], best[1]);
+    std::printf("%-8s %-13s %-6s %10.3f %10.3f\n", type_name, order_name, "encode", best[2], best[3]);
+}
+
+}
+
+int main()
+{
+    // One extra byte to run everything at an odd (unaligned) offset.
+    std::vector<uint8_t> storage(Values * sizeof(uint64_t) + 1, 0x5a);
+    uint8_t *buf = &storage[1];
+
+    std::printf("%s per value, %lu values at an unaligned offset\n",
+                bench::unit(), static_cast<unsigned long>(Values));
+    std::printf("%-8s %-13s %-6s %10s %10s\n", "type", "order", "op", "before", "after");
+    run<legacy::big_endian, bin::big_endian, uint16_t>("uint16", "big_endian", buf);
+    run<legacy::big_endian, bin::big_endian, uint32_t>("uint32", "big_endian", buf);
+    run<legacy::big_endian, bin::big_endian, uint64_t>("uint64", "big_endian", buf);
+    run<legacy::little_endian, bin::little_endian, uint16_t>("uint16", "little_endian", buf);
+    run<legacy::little_endian, bin::little_endian, uint32_t>("uint32", "little_endian", buf);
+    run<legacy::little_endian, bin::little_endian, uint64_t>("uint64", "little_endian", buf);
+    return 0;
+}
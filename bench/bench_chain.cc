@@ -0,0 +1,103 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares putting values one by one into a contiguous buffer and into
+// a chain of pooled chunks. Both go through the same encoder taking the
+// buffer by reference, as real encoders do.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_chain.cc -o bench_chain
+
+#include "bench.h"
+#include "encoding/binary/chain_buffer.h"
+#include <algorithm>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+const std::size_t Values = 1 << 20;
+
+template <typename BufferType>
+__attribute__((noinline)) void encode(BufferType &buf, const uint32_t *src)
+{
+    for (std::size_t i = 0; i < Values; ++i) buf.put(src[i]);
+}
+
+struct put_contiguous {
+    uint8_t *dst;
+    const uint32_t *src;
+    void operator()() const {
+        bin::writeonly_buffer buf(dst, Values * sizeof(uint32_t));
+        encode(buf, src);
+        bench::keep(dst[0]);
+    }
+};
+
+struct put_chain {
+    bin::chunk_pool *pool;
+    const uint32_t *src;
+    void operator()() const {
+        bin::chain_buffer buf(*pool);
+        encode(buf, src);
+        bench::keep(buf.size());
+    }
+};
+
+}
+
+int main()
+{
+    std::vector<uint32_t> values(Values);
+    for (std::size_t i = 0; i < Values; ++i) values[i] = uint32_t(i * 2654435761u);
+    std::vector<uint8_t> bytes(Values * sizeof(uint32_t));
+
+    // Trials of all variants are interleaved, so a burst of noise on a
+    // busy machine doesn't favour one of them.
+    const std::size_t sizes[] = {4096, 16384, 65536, 262144};
+    bin::chunk_pool pool0(sizes[0]), pool1(sizes[1]), pool2(sizes[2]), pool3(sizes[3]);
+    bin::chunk_pool *pools[] = {&pool0, &pool1, &pool2, &pool3};
+    put_contiguous contiguous = {&bytes[0], &values[0]};
+    double best[5] = {1e30, 1e30, 1e30, 1e30, 1e30};
+    for (int round = 0; round < 40; ++round) {
+        best[0] = std::min(best[0], bench::measure(contiguous, Values, 5));
+        for (std::size_t i = 0; i < 4; ++i) {
+            put_chain chain = {pools[i], &values[0]};
+            best[i + 1] = std::min(best[i + 1], bench::measure(chain, Values, 5));
+        }
+    }
+    std::printf("%s per uint32, %lu values\n", bench::unit(), static_cast<unsigned long>(Values));
+    std::printf("%-13s %10.3f\n", "contiguous", best[0]);
+    for (std::size_t i = 0; i < 4; ++i) {
+        std::printf("chunks %-6lu %10.3f %+9.1f%%\n", static_cast<unsigned long>(sizes[i]),
+                    best[i + 1], 100.0 * (best[i + 1] / best[0] - 1.0));
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares decoding a frame received as several segments by gathering
+// it into a contiguous array first and by reading the segments in
+// place. Segment sizes are odd, so some values straddle boundaries.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_segmented.cc -o bench_segmented
+
+#include "bench.h"
+#include "encoding/binary/segmented_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+const std::size_t Values = 1 << 20;
+
+template <typename BufferType>
+__attribute__((noinline)) uint32_t decode(BufferType &buf)
+{
+    uint32_t sum = 0;
+    for (std::size_t i = 0; i < Values; ++i) {
+        uint32_t value;
+        buf.get(value);
+        sum += value;
+    }
+    return sum;
+}
+
+struct gather_and_read {
+    const std::vector<bin::io_slice> *segments;
+    uint8_t *frame;
+    void operator()() const {
+        uint8_t *dst = frame;
+        for (std::size_t i = 0; i < segments->size(); ++i) {
+            std::memcpy(dst, (*segments)[i].iov_base, (*segments)[i].iov_len);
+            dst += (*segments)[i].iov_len;
+        }
+        bin::readonly_buffer buf(frame, std::size_t(dst - frame));
+        bench::keep(decode(buf));
+    }
+};
+
+struct read_segments {
+    const std::vector<bin::io_slice> *segments;
+    void operator()() const {
+        bin::segmented_buffer buf(&(*segments)[0], segments->size());
+        bench::keep(decode(buf));
+    }
+};
+
+}
+
+int main()
+{
+    std::vector<uint8_t> bytes(Values * sizeof(uint32_t));
+    for (std::size_t i = 0; i < bytes.size(); ++i) bytes[i] = uint8_t(i * 2654435761u >> 24);
+    std::vector<uint8_t> frame(bytes.size());
+
+    std::printf("%s per uint32, %lu values\n", bench::unit(), static_cast<unsigned long>(Values));
+    const std::size_t sizes[] = {1499, 8999, 65535};
+    for (std::size_t i = 0; i < 3; ++i) {
+        std::vector<bin::io_slice> segments;
+        for (std::size_t from = 0; from < bytes.size(); from += sizes[i]) {
+            bin::io_slice slice;
+            slice.iov_base = &bytes[from];
+            slice.iov_len = std::min(sizes[i], bytes.size() - from);
+            segments.push_back(slice);
+        }
+        gather_and_read gather = {&segments, &frame[0]};
+        read_segments segmented = {&segments};
+        std::printf("segment %-6lu gather %8.3f  in place %8.3f\n",
+                    static_cast<unsigned long>(sizes[i]),
+                    bench::measure(gather, Values, 20),
+                    bench::measure(segmented, Values, 20));
+    }
+    return 0;
+}
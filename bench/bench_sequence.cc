@@ -0,0 +1,114 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares ways of putting a byte sequence into a buffer: the old
+// byte-at-a-time loop, memcpy and non-temporal stores, for payloads
+// from L1-sized to much larger than the last level cache.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_sequence.cc -o bench_sequence
+
+#include "bench.h"
+#include "encoding/binary/buffer.h"
+#include <cstring>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+// Copy loop used by basic_buffer::put(const value_type*, size_t)
+// before it switched to a single bounds check.
+struct put_loop {
+    uint8_t *dst;
+    const uint8_t *src;
+    std::size_t length;
+    void operator()() const {
+        uint8_t *pos = dst;
+        const uint8_t *const end = dst + length;
+        const uint8_t *from = src;
+        const uint8_t *const to = src + length;
+        for (; from != to && pos != end; ++pos, ++from) {
+            *pos = *from;
+        }
+        bench::keep(dst[0]);
+    }
+};
+
+struct put_memcpy {
+    uint8_t *dst;
+    const uint8_t *src;
+    std::size_t length;
+    void operator()() const {
+        std::memcpy(dst, src, length);
+        bench::keep(dst[0]);
+    }
+};
+
+#if ENCODING_BINARY_HAS_SSE2
+struct put_stream {
+    uint8_t *dst;
+    const uint8_t *src;
+    std::size_t length;
+    void operator()() const {
+        bin::details::stream_copy_sse2(dst, src, length);
+        bench::keep(dst[0]);
+    }
+};
+#endif
+
+void run(std::size_t length)
+{
+    std::vector<uint8_t> src(length, 0x5a);
+    std::vector<uint8_t> dst(length + 1);
+    const int trials = length > (std::size_t(1) << 24) ? 5 : 20;
+
+    put_loop loop = {&dst[1], &src[0], length};
+    put_memcpy copy = {&dst[1], &src[0], length};
+    std::printf("%10lu %10.3f %10.3f", static_cast<unsigned long>(length),
+                bench::measure(loop, length, trials), bench::measure(copy, length, trials));
+#if ENCODING_BINARY_HAS_SSE2
+    put_stream stream = {&dst[1], &src[0], length};
+    std::printf(" %10.3f", bench::measure(stream, length, trials));
+#endif
+    std::printf("\n");
+}
+
+}
+
+int main()
+{
+    std::printf("%s per byte, streaming threshold %lu bytes\n", bench::unit(),
+                static_cast<unsigned long>(ENCODING_BINARY_STREAMING_THRESHOLD));
+    std::printf("%10s %10s %10s %10s\n", "bytes", "loop", "memcpy", "stream");
+    for (std::size_t length = 1 << 12; length <= (std::size_t(1) << 26); length <<= 2) {
+        run(length);
+    }
+    return 0;
+}
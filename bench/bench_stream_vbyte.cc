@@ -0,0 +1,100 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures Stream VByte decoding of small uint32 values against
+// per-value LEB128 varints, for every instruction set level the
+// running CPU supports.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_stream_vbyte.cc -o bench_stream_vbyte
+
+#include "bench.h"
+#include "encoding/binary/stream_vbyte.h"
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+const std::size_t Values = 1 << 20;
+
+struct decode_varints {
+    const uint8_t *src;
+    std::size_t length;
+    uint32_t *dst;
+    void operator()() const {
+        bin::readonly_buffer buf(src, length);
+        for (std::size_t i = 0; i < Values; ++i) buf.get_varint(dst[i]);
+        bench::keep(dst[0]);
+    }
+};
+
+struct decode_stream_vbyte {
+    const uint8_t *src;
+    std::size_t length;
+    uint32_t *dst;
+    void operator()() const {
+        bin::readonly_buffer buf(src, length);
+        bin::get_stream_vbyte(buf, dst, Values);
+        bench::keep(dst[0]);
+    }
+};
+
+}
+
+int main()
+{
+    std::vector<uint32_t> values(Values);
+    uint64_t seed = 1;
+    for (std::size_t i = 0; i < Values; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        values[i] = uint32_t(seed >> 32) >> (8 + (seed >> 60));
+    }
+    std::vector<uint8_t> varints(Values * 5);
+    bin::writeonly_buffer vw(&varints[0], varints.size());
+    for (std::size_t i = 0; i < Values; ++i) vw.put_varint(values[i]);
+    std::vector<uint8_t> svb(bin::stream_vbyte_size(&values[0], Values));
+    bin::writeonly_buffer sw(&svb[0], svb.size());
+    bin::put_stream_vbyte(sw, &values[0], Values);
+
+    std::vector<uint32_t> out(Values);
+    decode_varints dv = {&varints[0], varints.size() - vw.bytes_left(), &out[0]};
+    decode_stream_vbyte ds = {&svb[0], svb.size(), &out[0]};
+
+    std::printf("%s per value, %lu values, %.2f bytes per value\n", bench::unit(),
+                static_cast<unsigned long>(Values), double(svb.size()) / Values);
+    std::printf("%-8s %10s %12s\n", "kernels", "varint", "stream vbyte");
+    const bin::cpu_level detected = bin::detected_cpu_level();
+    for (int level = bin::cpu_level_scalar; level <= detected; ++level) {
+        bin::force_cpu_level(bin::cpu_level(level));
+        std::printf("%-8s %10.3f %12.3f\n", bin::cpu_level_name(bin::active_cpu_level()),
+                    bench::measure(dv, Values, 20), bench::measure(ds, Values, 20));
+    }
+    return 0;
+}
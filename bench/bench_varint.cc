@@ -0,0 +1,107 @@
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compares decoding a stream of varints of mixed lengths byte at a
+// time with the word-at-a-time decoder used by get_varint.
+//
+// Build with optimizations, e.g.:
+//   g++ -O2 -Iinclude bench/bench_varint.cc -o bench_varint
+// Add -mbmi2 to compact groups with pext.
+
+#include "bench.h"
+#include "encoding/binary/buffer.h"
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+const std::size_t Values = 1 << 20;
+
+struct decode_slow {
+    const uint8_t *src;
+    std::size_t length;
+    void operator()() const {
+        uint64_t sum = 0;
+        for (std::size_t pos = 0; pos < length; ) {
+            uint64_t value = 0;
+            const std::size_t size = bin::details::decode_varint_slow(src + pos, length - pos, value);
+            if (size == 0 || size == bin::details::varint_malformed) break;
+            pos += size;
+            sum += value;
+        }
+        bench::keep(sum);
+    }
+};
+
+struct decode_buffer {
+    const uint8_t *src;
+    std::size_t length;
+    void operator()() const {
+        bin::readonly_buffer buf(src, length);
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < Values; ++i) {
+            uint64_t value = 0;
+            buf.get_varint(value);
+            sum += value;
+        }
+        bench::keep(sum);
+    }
+};
+
+void run(const char *name, unsigned max_bits)
+{
+    std::vector<uint8_t> bytes(Values * 10);
+    bin::writeonly_buffer wr(&bytes[0], bytes.size());
+    uint64_t seed = 42;
+    for (std::size_t i = 0; i < Values; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        const unsigned bits = unsigned(seed >> 58) % max_bits + 1;
+        wr.put_varint((seed >> 3) >> (64 - bits));
+    }
+    const std::size_t length = bytes.size() - wr.bytes_left();
+
+    decode_slow slow = {&bytes[0], length};
+    decode_buffer fast = {&bytes[0], length};
+    std::printf("%-10s %8.2f %10.3f %10.3f\n", name, double(length) / Values,
+                bench::measure(slow, Values, 20), bench::measure(fast, Values, 20));
+}
+
+}
+
+int main()
+{
+    std::printf("%s per value, %lu values\n", bench::unit(), static_cast<unsigned long>(Values));
+    std::printf("%-10s %8s %10s %10s\n", "values", "bytes", "loop", "get_varint");
+    run("7 bits", 7);
+    run("14 bits", 14);
+    run("32 bits", 32);
+    run("61 bits", 61);
+    return 0;
+}
@@ -0,0 +1,634 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_BIT_BUFFER_H_
+#define ENCODING_BINARY_BIT_BUFFER_H_
+
+#include "encoding/binary/buffer.h"
+
+/**
+ * @file
+ * @brief Implementation of bit-granular buffers.
+ *
+ * Bits are packed most significant bit first: the first bit put into
+ * a buffer becomes the highest bit of its first byte. Multi-bit
+ * fields are stored with their most significant bit first as well,
+ * which is the layout used by most network and media formats.
+ *
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+namespace details {
+
+/**
+ * @brief Returns `value` with all but `nbits` low bits cleared.
+ */
+ENCODING_BINARY_CONSTEXPR inline uint64_t low_bits(uint64_t value, unsigned nbits)
+{
+    return nbits >= 64 ? value : value & ((uint64_t(1) << nbits) - 1);
+}
+
+/**
+ * @brief Loads up to 8 bytes as a big-endian number aligned to the
+ * most significant byte. Missing bytes are zeroes.
+ */
+ENCODING_BINARY_CONSTEXPR inline uint64_t load_be_prefix(const uint8_t *buf, std::size_t length)
+{
+    return to_big(load_prefix<uint64_t>(buf, length < 8 ? length : 8));
+}
+
+}
+
+/**
+ * @brief Bit buffer that reads or writes fields of 1 to 64 bits.
+ *
+ * Only `read_access_tag` and `write_access_tag` specializations are
+ * defined: the 64-bit accumulator either holds bits that are read
+ * ahead or bits that are not written yet, but not both.
+ *
+ * Like in `basic_buffer`, a field that doesn't fit is reported to the
+ * overflow policy and moves the buffer to its end.
+ *
+ * @tparam AccessTag type tag that restricts operations on buffer
+ * @tparam OverflowPolicy what to do when a field doesn't fit, see
+ * overflow.h
+ */
+template <typename AccessTag, typename OverflowPolicy>
+class basic_bit_buffer;
+
+/**
+ * @brief Writing bit buffer.
+ *
+ * Fields are collected in a register-resident 64-bit accumulator
+ * that is stored as a whole big-endian word once it's full. Call
+ * `flush` to store the remaining bits (padded with zeroes up to the
+ * byte boundary) when done.
+ *
+ *     begin         pos     pos + pending bits       end
+ *       V            V         V                      V
+ *       |------------|=========|----------------------|
+ */
+template <typename OverflowPolicy>
+class basic_bit_buffer<write_access_tag, OverflowPolicy> : public OverflowPolicy
+{
+public:
+    typedef write_access_tag access_tag;
+    typedef OverflowPolicy overflow_policy;
+    typedef access_traits<access_tag>::value_type value_type;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+
+    basic_bit_buffer(iterator begin, iterator end)
+        : begin_(begin)
+        , end_(end)
+        , pos_(begin)
+        , acc_(0)
+        , filled_(0)
+    {}
+
+    template <std::size_t Size>
+    basic_bit_buffer(value_type (&buf)[Size])
+        : begin_(buf)
+        , end_(buf + Size)
+        , pos_(buf)
+        , acc_(0)
+        , filled_(0)
+    {}
+
+    basic_bit_buffer(iterator begin, std::size_t length)
+        : begin_(begin)
+        , end_(begin + length)
+        , pos_(begin)
+        , acc_(0)
+        , filled_(0)
+    {}
+
+    /**
+     * @brief Returns beginning of a buffer.
+     */
+    const_iterator begin() const { return begin_; }
+
+    /**
+     * @brief Returns end of a buffer.
+     */
+    const_iterator end() const { return end_; }
+
+    /**
+     * @brief Returns total size of buffer in bits.
+     */
+    std::size_t size_bits() const { return 8 * std::size_t(end_ - begin_); }
+
+    /**
+     * @brief Returns number of bits written so far, including the
+     * ones not flushed yet.
+     */
+    std::size_t bits_written() const { return 8 * std::size_t(pos_ - begin_) + filled_; }
+
+    /**
+     * @brief Returns number of bits that can still be written.
+     */
+    std::size_t bits_left() const { return size_bits() - bits_written(); }
+
+    /**
+     * @brief Writes `nbits` low bits of `value`. Higher bits of
+     * `value` are ignored.
+     * @param value field value
+     * @param nbits field width, from 0 to 64
+     * @return current buffer
+     */
+    basic_bit_buffer & put_bits(uint64_t value, unsigned nbits)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bits_left() < nbits)) return overflow();
+        if (nbits == 0) return *this;
+        value = details::low_bits(value, nbits);
+        const unsigned free = 64 - filled_;
+        if (nbits < free) {
+            acc_ |= value << (free - nbits);
+            filled_ += nbits;
+        } else {
+            const unsigned rest = nbits - free;
+            details::store(details::to_big(acc_ | value >> rest), pos_);
+            pos_ += 8;
+            filled_ = rest;
+            acc_ = rest ? value << (64 - rest) : 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Writes a single bit.
+     * @return current buffer
+     */
+    basic_bit_buffer & put_bit(bool bit)
+    {
+        return put_bits(bit, 1);
+    }
+
+    /**
+     * @brief Stores pending bits and pads the last byte with zero
+     * bits. Further writes start at the next byte boundary.
+     * @return current buffer
+     */
+    basic_bit_buffer & flush()
+    {
+        const std::size_t bytes = (filled_ + 7) / 8;
+        if (ENCODING_BINARY_UNLIKELY(std::size_t(end_ - pos_) < bytes)) return overflow();
+        details::store_prefix(details::to_big(acc_), pos_, bytes);
+        pos_ += bytes;
+        acc_ = 0;
+        filled_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief Discards everything written and moves to the beginning.
+     * @return current buffer
+     */
+    basic_bit_buffer & reset()
+    {
+        pos_ = begin_;
+        acc_ = 0;
+        filled_ = 0;
+        return *this;
+    }
+
+private:
+    // Pending bits are dropped: the output is broken anyway.
+    basic_bit_buffer & overflow()
+    {
+        overflow_policy::on_overflow();
+        pos_ += end_ - pos_;
+        acc_ = 0;
+        filled_ = 0;
+        return *this;
+    }
+
+    iterator begin_;
+    const_iterator end_;
+    iterator pos_;       // first byte not stored yet
+    uint64_t acc_;       // pending bits, aligned to the most significant bit
+    unsigned filled_;    // number of pending bits, always less than 64
+};
+
+/**
+ * @brief Reading bit buffer.
+ *
+ * Input is read ahead into a 64-bit accumulator with a single
+ * unaligned load whenever there are at least 8 bytes left, so
+ * extracting a field is a shift in the common case.
+ */
+template <typename OverflowPolicy>
+class basic_bit_buffer<read_access_tag, OverflowPolicy> : public OverflowPolicy
+{
+public:
+    typedef read_access_tag access_tag;
+    typedef OverflowPolicy overflow_policy;
+    typedef access_traits<access_tag>::value_type value_type;
+    typedef access_traits<access_tag>::strict_type strict_type;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+
+    basic_bit_buffer(iterator begin, iterator end)
+        : begin_(begin)
+        , end_(end)
+        , pos_(begin)
+        , acc_(0)
+        , avail_(0)
+    {}
+
+    template <std::size_t Size>
+    basic_bit_buffer(strict_type (&buf)[Size])
+        : begin_(buf)
+        , end_(buf + Size)
+        , pos_(buf)
+        , acc_(0)
+        , avail_(0)
+    {}
+
+    basic_bit_buffer(iterator begin, std::size_t length)
+        : begin_(begin)
+        , end_(begin + length)
+        , pos_(begin)
+        , acc_(0)
+        , avail_(0)
+    {}
+
+    /**
+     * @brief Returns beginning of a buffer.
+     */
+    const_iterator begin() const { return begin_; }
+
+    /**
+     * @brief Returns end of a buffer.
+     */
+    const_iterator end() const { return end_; }
+
+    /**
+     * @brief Returns total size of buffer in bits.
+     */
+    std::size_t size_bits() const { return 8 * std::size_t(end_ - begin_); }
+
+    /**
+     * @brief Returns number of bits consumed so far.
+     */
+    std::size_t bits_read() const { return 8 * std::size_t(pos_ - begin_) - avail_; }
+
+    /**
+     * @brief Returns number of bits that can still be read.
+     */
+    std::size_t bits_left() const { return size_bits() - bits_read(); }
+
+    /**
+     * @brief Reads a field of `nbits` bits.
+     * @param nbits field width, from 0 to 64
+     * @return field value, 0 if the field doesn't fit
+     */
+    uint64_t get_bits(unsigned nbits)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bits_left() < nbits)) {
+            overflow();
+            return 0;
+        }
+        if (nbits > 56) {
+            const uint64_t high = take(nbits - 32);
+            return high << 32 | take(32);
+        }
+        return take(nbits);
+    }
+
+    /**
+     * @brief Reads a field of `nbits` bits.
+     * @param value reference to field value
+     * @param nbits field width, from 0 to 64
+     * @return current buffer
+     */
+    template <typename T>
+    basic_bit_buffer & get_bits(T &value, unsigned nbits)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bits_left() < nbits)) {
+            overflow();
+            return *this;
+        }
+        value = T(get_bits(nbits));
+        return *this;
+    }
+
+    /**
+     * @brief Reads a single bit.
+     */
+    bool get_bit()
+    {
+        return get_bits(1) != 0;
+    }
+
+    /**
+     * @brief Skips bits up to the next byte boundary.
+     * @return current buffer
+     */
+    basic_bit_buffer & align()
+    {
+        const unsigned extra = avail_ % 8;
+        acc_ <<= extra;
+        avail_ -= extra;
+        return *this;
+    }
+
+    /**
+     * @brief Moves to the beginning of a buffer.
+     * @return current buffer
+     */
+    basic_bit_buffer & reset()
+    {
+        pos_ = begin_;
+        acc_ = 0;
+        avail_ = 0;
+        return *this;
+    }
+
+private:
+    // Requires nbits <= 56 and bits_left() >= nbits.
+    uint64_t take(unsigned nbits)
+    {
+        if (avail_ < nbits) refill();
+        if (nbits == 0) return 0;
+        const uint64_t value = acc_ >> (64 - nbits);
+        acc_ <<= nbits;
+        avail_ -= nbits;
+        return value;
+    }
+
+    // Tops the accumulator up to at least 56 bits or to the end of input.
+    void refill()
+    {
+        if (end_ - pos_ >= 8) {
+            acc_ |= details::to_big(details::load<uint64_t>(pos_)) >> avail_;
+            pos_ += (63 - avail_) >> 3;
+            avail_ |= 56;
+        } else {
+            for (; avail_ <= 56 && pos_ != end_; ++pos_, avail_ += 8) {
+                acc_ |= uint64_t(*pos_) << (56 - avail_);
+            }
+        }
+    }
+
+    void overflow()
+    {
+        overflow_policy::on_overflow();
+        pos_ += end_ - pos_;
+        acc_ = 0;
+        avail_ = 0;
+    }
+
+    iterator begin_;
+    const_iterator end_;
+    iterator pos_;       // first byte not loaded into the accumulator
+    uint64_t acc_;       // unread bits, aligned to the most significant bit
+    unsigned avail_;     // number of unread bits in the accumulator
+};
+
+/**
+ * @brief Bit buffer with compile-time bounds checking.
+ *
+ * Like `basic_static_buffer`, the position is a template parameter
+ * and every modifier returns a buffer of a new type, so all checks
+ * and offset computations happen at compile time. Only
+ * `read_access_tag` and `write_access_tag` specializations are
+ * defined.
+ *
+ * @tparam AccessTag type tag that restricts operations on buffer
+ * @tparam Size size of a buffer in bytes
+ * @tparam BitOffset number of bits read or written
+ */
+template <
+    typename AccessTag,
+    std::size_t Size,
+    std::size_t BitOffset
+    >
+class basic_static_bit_buffer;
+
+/**
+ * @brief Writing static bit buffer. The bit accumulator travels
+ * along the chain of returned buffers and is stored as a whole
+ * 64-bit word once full; call `flush` to store the rest.
+ */
+template <std::size_t Size, std::size_t BitOffset>
+class basic_static_bit_buffer<write_access_tag, Size, BitOffset>
+{
+    template <typename, std::size_t, std::size_t>
+    friend class basic_static_bit_buffer;
+
+    static const unsigned filled = BitOffset % 64;
+    static const std::size_t word = BitOffset / 64 * 8;
+
+public:
+    typedef write_access_tag access_tag;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+    typedef basic_static_bit_buffer<access_tag, Size, (BitOffset + 7) / 8 * 8> flushed_buffer;
+
+    basic_static_bit_buffer(iterator begin)
+        : begin_(begin)
+        , acc_(0)
+    {}
+
+    /**
+     * @brief Returns pointer to first element of the buffer.
+     */
+    const_iterator begin() const { return begin_; }
+
+    /**
+     * @brief Returns number of bits written, including pending ones.
+     */
+    std::size_t bits_written() const { return BitOffset; }
+
+    /**
+     * @brief Returns number of bits that can still be written.
+     */
+    std::size_t bits_left() const { return 8 * Size - BitOffset; }
+
+    /**
+     * @brief Writes `NBits` low bits of `value`.
+     * @tparam NBits field width, from 0 to 64
+     * @return new buffer with updated offset
+     */
+    template <unsigned NBits>
+    typename details::enable_if<
+        NBits <= 64 && BitOffset + NBits <= 8 * Size,
+        basic_static_bit_buffer<access_tag, Size, BitOffset + NBits>
+        >::type put_bits(uint64_t value) const
+    {
+        typedef basic_static_bit_buffer<access_tag, Size, BitOffset + NBits> next;
+        value = details::low_bits(value, NBits);
+        const unsigned free = 64 - filled;
+        if (NBits < free) {
+            return next(begin_, NBits ? acc_ | value << (free - NBits) % 64 : acc_);
+        }
+        // Shift counts are reduced modulo 64 to keep the branch that
+        // isn't taken for this instantiation well-formed.
+        const unsigned rest = (NBits - free) % 64;
+        details::store(details::to_big(acc_ | value >> rest), begin_ + word);
+        return next(begin_, rest ? value << (64 - rest) % 64 : 0);
+    }
+
+    /**
+     * @brief Stores pending bits padding the last byte with zeroes.
+     * @return new buffer positioned at the next byte boundary
+     */
+    flushed_buffer flush() const
+    {
+        details::store_prefix(details::to_big(acc_), begin_ + word, (filled + 7) / 8);
+        // Unless the padding completes the word, keep its bits to store
+        // them again along with the bits that follow.
+        return flushed_buffer(begin_, ((BitOffset + 7) / 8 * 8) % 64 ? acc_ : 0);
+    }
+
+private:
+    basic_static_bit_buffer(iterator begin, uint64_t acc)
+        : begin_(begin)
+        , acc_(acc)
+    {}
+
+    iterator begin_;
+    uint64_t acc_;
+};
+
+/**
+ * @brief Reading static bit buffer. Every field is extracted with
+ * one load (two for fields wider than 56 bits) at an offset known
+ * at compile time.
+ */
+template <std::size_t Size, std::size_t BitOffset>
+class basic_static_bit_buffer<read_access_tag, Size, BitOffset>
+{
+public:
+    typedef read_access_tag access_tag;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+    typedef basic_static_bit_buffer<access_tag, Size, (BitOffset + 7) / 8 * 8> aligned_buffer;
+
+    basic_static_bit_buffer(iterator begin)
+        : begin_(begin)
+    {}
+
+    /**
+     * @brief Returns pointer to first element of the buffer.
+     */
+    const_iterator begin() const { return begin_; }
+
+    /**
+     * @brief Returns number of bits read.
+     */
+    std::size_t bits_read() const { return BitOffset; }
+
+    /**
+     * @brief Returns number of bits that can still be read.
+     */
+    std::size_t bits_left() const { return 8 * Size - BitOffset; }
+
+    /**
+     * @brief Reads a field of `NBits` bits.
+     * @tparam NBits field width, from 0 to 64
+     * @return new buffer with updated offset
+     */
+    template <unsigned NBits, typename T>
+    typename details::enable_if<
+        NBits <= 64 && BitOffset + NBits <= 8 * Size,
+        basic_static_bit_buffer<access_tag, Size, BitOffset + NBits>
+        >::type get_bits(T &value) const
+    {
+        value = T(read(BitOffset, NBits));
+        return basic_static_bit_buffer<access_tag, Size, BitOffset + NBits>(begin_);
+    }
+
+    /**
+     * @brief Skips bits up to the next byte boundary.
+     * @return new buffer with updated offset
+     */
+    aligned_buffer align() const
+    {
+        return aligned_buffer(begin_);
+    }
+
+private:
+    uint64_t read(std::size_t offset, unsigned nbits) const
+    {
+        if (nbits == 0) return 0;
+        if (nbits > 56) {
+            return read(offset, nbits - 32) << 32 | read(offset + nbits - 32, 32);
+        }
+        const std::size_t byte = offset / 8;
+        const uint64_t bits = details::load_be_prefix(begin_ + byte, Size - byte);
+        return bits << (offset % 8) >> (64 - nbits);
+    }
+
+    iterator begin_;
+};
+
+/**
+ * @brief Writing static bit buffer template.
+ */
+template <std::size_t Size, std::size_t BitOffset = 0>
+class writeonly_static_bit_buffer :
+    public basic_static_bit_buffer<write_access_tag, Size, BitOffset>
+{
+public:
+    typedef basic_static_bit_buffer<write_access_tag, Size, BitOffset> base;
+    typedef typename base::iterator iterator;
+
+    writeonly_static_bit_buffer(base const &b): base(b)
+    {}
+
+    writeonly_static_bit_buffer(iterator begin): base(begin)
+    {}
+};
+
+/**
+ * @brief Reading static bit buffer template.
+ */
+template <std::size_t Size, std::size_t BitOffset = 0>
+class readonly_static_bit_buffer :
+    public basic_static_bit_buffer<read_access_tag, Size, BitOffset>
+{
+public:
+    typedef basic_static_bit_buffer<read_access_tag, Size, BitOffset> base;
+    typedef typename base::iterator iterator;
+
+    readonly_static_bit_buffer(base const &b): base(b)
+    {}
+
+    readonly_static_bit_buffer(iterator begin): base(begin)
+    {}
+};
+
+} }
+
+#endif /* ENCODING_BINARY_BIT_BUFFER_H_ */
@@ -32,18 +32,32 @@
 #ifndef ENCODING_BINARY_BUF_FWD_H_
 #define ENCODING_BINARY_BUF_FWD_H_
 
+#include <cstddef>
+#include "encoding/binary/config.h"
+
 /**
  * @file
  * @brief Forward declarations for binary buffers templates.
  */
 namespace encoding { namespace binary {
 
+struct throw_on_overflow;
+struct abort_on_overflow;
+class sticky_overflow;
+
 template <
     typename ByteOrder,
-    typename AccessTag
+    typename AccessTag,
+    typename OverflowPolicy = throw_on_overflow
     >
 class basic_buffer;
 
+template <
+    typename ByteOrder,
+    typename AccessTag
+    >
+class basic_window;
+
 template <
     typename ByteOrder,
     typename AccessTag,
@@ -61,9 +75,23 @@ class readonly_static_buffer;
 template <std::size_t Size, std::size_t Offset>
 class writeonly_static_buffer;
 
+template <
+    typename AccessTag,
+    typename OverflowPolicy = throw_on_overflow
+    >
+class basic_bit_buffer;
+
+template <
+    typename AccessTag,
+    std::size_t Size,
+    std::size_t BitOffset
+    >
+class basic_static_bit_buffer;
+
 struct big_endian;
 struct little_endian;
 struct native_endian;
+struct aligned_native_endian;
 
 struct read_access_tag {
     static const bool readable = true;
@@ -78,16 +106,38 @@ struct read_write_access_tag : read_access_tag, write_access_tag {
     using write_access_tag::writable;
 };
 
-typedef big_endian default_byte_order;
+/**
+ * @brief Network (big-endian) byte order resolved at compile time:
+ * a plain copy on big-endian hosts, a byte swap elsewhere. Both
+ * produce the same bytes.
+ */
+#if ENCODING_BINARY_HOST_BIG_ENDIAN
+typedef native_endian network_order;
+#else
+typedef big_endian network_order;
+#endif
+
+typedef network_order default_byte_order;
 
 typedef basic_buffer<default_byte_order, read_write_access_tag> buffer;
 typedef basic_buffer<default_byte_order, read_access_tag> readonly_buffer;
 typedef basic_buffer<default_byte_order, write_access_tag> writeonly_buffer;
 
+typedef basic_buffer<network_order, read_write_access_tag> network_buffer;
+typedef basic_buffer<network_order, read_access_tag> network_readonly_buffer;
+typedef basic_buffer<network_order, write_access_tag> network_writeonly_buffer;
+
 typedef basic_buffer<little_endian, read_write_access_tag> le_buffer;
 typedef basic_buffer<little_endian, read_access_tag> le_readonly_buffer;
 typedef basic_buffer<little_endian, write_access_tag> le_writeonly_buffer;
 
+typedef basic_bit_buffer<read_access_tag> readonly_bit_buffer;
+typedef basic_bit_buffer<write_access_tag> writeonly_bit_buffer;
+
+typedef basic_buffer<aligned_native_endian, read_write_access_tag> aligned_buffer;
+typedef basic_buffer<aligned_native_endian, read_access_tag> aligned_readonly_buffer;
+typedef basic_buffer<aligned_native_endian, write_access_tag> aligned_writeonly_buffer;
+
 
 } }
 
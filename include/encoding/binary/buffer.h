@@ -34,8 +34,12 @@
 
 #include <stdint.h>
 #include <cstring>
-#include <stdexcept>
+#include <utility>
 #include "encoding/binary/buf_fwd.h"
+#include "encoding/binary/byte_swap.h"
+#include "encoding/binary/kernels.h"
+#include "encoding/binary/overflow.h"
+#include "encoding/binary/varint.h"
 
 /**
  * @file
@@ -44,17 +48,13 @@
  */
 namespace encoding { namespace binary {
 
-namespace {
-
-const char * const OutOfRangeMessage = "Buffer out of bounds";
-std::out_of_range Overflow(OutOfRangeMessage);
-
-}
-
 namespace details {
 
 template <typename AccessTag>
-void assert_access(AccessTag) {}
+ENCODING_BINARY_CONSTEXPR inline void assert_access(AccessTag) {}
+
+template <bool Cond> struct static_check;
+template <> struct static_check<true> {};
 
 template<bool Cond, class T = void> struct enable_if {};
 template<class T> struct enable_if<true, T> {
@@ -63,6 +63,136 @@ template<class T> struct enable_if<true, T> {
 
 }
 
+/**
+ * @defgroup OddWidth integers occupying 3, 5, 6 or 7 bytes on the wire.
+ * @{
+ */
+
+/**
+ * @brief Unsigned integer stored in `Storage` but encoded as its
+ * `Bytes` least significant bytes. Higher bits are dropped on
+ * encoding and are zero after decoding.
+ */
+template <typename Storage, std::size_t Bytes>
+struct packed_uint {
+    typedef Storage storage_type;
+
+    ENCODING_BINARY_CONSTEXPR packed_uint() : value() {}
+    ENCODING_BINARY_CONSTEXPR packed_uint(Storage v) : value(v) {}
+    ENCODING_BINARY_CONSTEXPR operator Storage() const { return value; }
+
+    Storage value;
+};
+
+typedef packed_uint<uint32_t, 3> uint24_t;
+typedef packed_uint<uint64_t, 5> uint40_t;
+typedef packed_uint<uint64_t, 6> uint48_t;
+typedef packed_uint<uint64_t, 7> uint56_t;
+
+/**
+ * @brief Compile-time function returning number of bytes a value of
+ * type `T` occupies in a buffer.
+ */
+template <typename T>
+struct wire_size {
+    static const std::size_t value = sizeof(T);
+};
+
+template <typename T>
+const std::size_t wire_size<T>::value;
+
+template <typename Storage, std::size_t Bytes>
+struct wire_size< packed_uint<Storage, Bytes> > {
+    static const std::size_t value = Bytes;
+};
+
+template <typename Storage, std::size_t Bytes>
+const std::size_t wire_size< packed_uint<Storage, Bytes> >::value;
+
+namespace details {
+
+/**
+ * @brief Encoding routines for `packed_uint`.
+ *
+ * `decode` touches exactly `Bytes` bytes. `decode_wide` requires
+ * `sizeof(Storage)` readable bytes and replaces the partial copy
+ * with one full-width load and a shift or mask.
+ *
+ * @tparam BigEndian whether the most significant byte goes first
+ */
+template <bool BigEndian>
+struct packed_codec;
+
+template <>
+struct packed_codec<true> {
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void encode(packed_uint<S, N> val, uint8_t *buf) {
+        store_prefix(to_big(S(val.value << shift<S, N>())), buf, N);
+    }
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, packed_uint<S, N> &val) {
+        val.value = to_big(load_prefix<S>(buf, N)) >> shift<S, N>();
+    }
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void decode_wide(const uint8_t *buf, packed_uint<S, N> &val) {
+        val.value = to_big(load<S>(buf)) >> shift<S, N>();
+    }
+
+private:
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static unsigned shift() { return unsigned(8 * (sizeof(S) - N)); }
+};
+
+template <>
+struct packed_codec<false> {
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void encode(packed_uint<S, N> val, uint8_t *buf) {
+        store_prefix(to_little(val.value), buf, N);
+    }
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, packed_uint<S, N> &val) {
+        val.value = to_little(load_prefix<S>(buf, N));
+    }
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static void decode_wide(const uint8_t *buf, packed_uint<S, N> &val) {
+        val.value = to_little(load<S>(buf)) & mask<S, N>();
+    }
+
+private:
+    template <typename S, std::size_t N>
+    ENCODING_BINARY_CONSTEXPR static S mask() { return S(~S(0)) >> (8 * (sizeof(S) - N)); }
+};
+
+/**
+ * @brief Decodes a value knowing that `available` bytes are readable
+ * from `buf`, which lets odd-width integers use a wide load when
+ * there is slack after them.
+ */
+template <typename T>
+struct slack_decoder {
+    template <typename ByteOrder>
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, std::size_t, T &val) {
+        ByteOrder::decode(buf, val);
+    }
+};
+
+template <typename S, std::size_t N>
+struct slack_decoder< packed_uint<S, N> > {
+    template <typename ByteOrder>
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, std::size_t available,
+                                                 packed_uint<S, N> &val) {
+        if (available >= sizeof(S)) {
+            ByteOrder::decode_wide(buf, val);
+        } else {
+            ByteOrder::decode(buf, val);
+        }
+    }
+};
+
+}
+
+/** @} */
+
 /**
  * @defgroup ByteOrder encoding strategies implementations.
  * @{
@@ -71,142 +201,417 @@ template<class T> struct enable_if<true, T> {
 /**
  * @brief Base for endian implementations. Contains no-op conversions
  * which are useful in templates.
+ *
+ * Every strategy encodes 8, 16, 32 and 64-bit signed and unsigned
+ * integers, `float`, `double` and odd-width `packed_uint` values
+ * (the latter also have `decode_wide`). Besides scalar `encode` and
+ * `decode`, it provides bulk
+ * `encode_array(const T *values, std::size_t count, uint8_t *buf)` and
+ * `decode_array(const uint8_t *buf, std::size_t count, T *values)`.
  */
 struct endian_base {
-    static void encode(uint8_t val, uint8_t *buf) {
+    ENCODING_BINARY_CONSTEXPR static void encode(uint8_t val, uint8_t *buf) {
         *buf = val;
     }
-    static void decode(const uint8_t *buf, uint8_t &val) {
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint8_t &val) {
         val = *buf;
     }
+    ENCODING_BINARY_CONSTEXPR static void encode(int8_t val, uint8_t *buf) {
+        *buf = uint8_t(val);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, int8_t &val) {
+        val = int8_t(*buf);
+    }
 };
 
+namespace details {
+
+/**
+ * @brief Signed and floating point overloads for a byte order
+ * strategy. Each one is a bit cast to the unsigned type of the same
+ * size followed by the unsigned routine of `ByteOrder`. For two's
+ * complement integers the cast is a plain conversion, which keeps
+ * them usable in constant expressions.
+ */
+template <typename ByteOrder>
+struct bit_cast_codec {
+    ENCODING_BINARY_CONSTEXPR static void encode(int16_t val, uint8_t *buf) {
+        ByteOrder::encode(uint16_t(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, int16_t &val) {
+        val = int16_t(decode_bits<uint16_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(int32_t val, uint8_t *buf) {
+        ByteOrder::encode(uint32_t(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, int32_t &val) {
+        val = int32_t(decode_bits<uint32_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(int64_t val, uint8_t *buf) {
+        ByteOrder::encode(uint64_t(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, int64_t &val) {
+        val = int64_t(decode_bits<uint64_t>(buf));
+    }
+    static void encode(float val, uint8_t *buf) {
+        ByteOrder::encode(bit_cast<uint32_t>(val), buf);
+    }
+    static void decode(const uint8_t *buf, float &val) {
+        val = bit_cast<float>(decode_bits<uint32_t>(buf));
+    }
+    static void encode(double val, uint8_t *buf) {
+        ByteOrder::encode(bit_cast<uint64_t>(val), buf);
+    }
+    static void decode(const uint8_t *buf, double &val) {
+        val = bit_cast<double>(decode_bits<uint64_t>(buf));
+    }
+
+private:
+    template <typename T>
+    ENCODING_BINARY_CONSTEXPR static T decode_bits(const uint8_t *buf) {
+        T bits = 0;
+        ByteOrder::decode(buf, bits);
+        return bits;
+    }
+};
+
+}
+
+namespace details {
+
+/**
+ * @brief Compile-time function to check if `T` is a byte order
+ * strategy, i.e. derives from `endian_base`.
+ */
+template <typename T>
+struct is_byte_order {
+    typedef char yes;
+    typedef char (&no)[2];
+    static yes check(const volatile endian_base *);
+    static no check(...);
+    static const bool value = sizeof(check(static_cast<T*>(0))) == sizeof(yes);
+};
+
+}
+
 /**
  * @brief Implementation of little-endian encoding routines.
+ *
+ * Each routine is a single unaligned load or store, followed or
+ * preceded by a byte swap on big-endian hosts. On little-endian hosts
+ * it's a plain move.
  */
-struct little_endian : public endian_base {
+struct little_endian
+    : public endian_base
+    , public details::bit_cast_codec<little_endian>
+    , public details::packed_codec<false>
+    , public details::array_codec<ENCODING_BINARY_HOST_BIG_ENDIAN> {
     using endian_base::encode;
     using endian_base::decode;
+    using details::bit_cast_codec<little_endian>::encode;
+    using details::bit_cast_codec<little_endian>::decode;
+    using details::packed_codec<false>::encode;
+    using details::packed_codec<false>::decode;
 
-    static void encode(uint16_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val);
-        buf[1] = uint8_t(val >> 8);
-    }
-    static void decode(const uint8_t *buf, uint16_t &val) {
-        val = uint16_t(buf[1] << 8) | buf[0];
-    }
-    static void encode(uint32_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val);
-        buf[1] = uint8_t(val >> 8);
-        buf[2] = uint8_t(val >> 16);
-        buf[3] = uint8_t(val >> 24);
-    }
-    static void decode(const uint8_t *buf, uint32_t &val) {
-        val = uint32_t(buf[3]) << 24 |
-            uint32_t(buf[2]) << 16 |
-            uint32_t(buf[1]) <<  8 |
-            buf[0];
-    }
-    static void encode(uint64_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val);
-        buf[1] = uint8_t(val >>  8);
-        buf[2] = uint8_t(val >> 16);
-        buf[3] = uint8_t(val >> 24);
-        buf[4] = uint8_t(val >> 32);
-        buf[5] = uint8_t(val >> 40);
-        buf[6] = uint8_t(val >> 48);
-        buf[7] = uint8_t(val >> 56);
-    }
-    static void decode(const uint8_t *buf, uint64_t &val) {
-        val = uint64_t(buf[7]) << 56 |
-            uint64_t(buf[6]) << 48 |
-            uint64_t(buf[5]) << 40 |
-            uint64_t(buf[4]) << 32 |
-            uint64_t(buf[3]) << 24 |
-            uint64_t(buf[2]) << 16 |
-            uint64_t(buf[1]) <<  8 |
-            buf[0];
+    ENCODING_BINARY_CONSTEXPR static void encode(uint16_t val, uint8_t *buf) {
+        details::store(details::to_little(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint16_t &val) {
+        val = details::to_little(details::load<uint16_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint32_t val, uint8_t *buf) {
+        details::store(details::to_little(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint32_t &val) {
+        val = details::to_little(details::load<uint32_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint64_t val, uint8_t *buf) {
+        details::store(details::to_little(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint64_t &val) {
+        val = details::to_little(details::load<uint64_t>(buf));
     }
 };
 
 /**
  * @brief Implementation of big-endian encoding routines.
+ *
+ * Same as `little_endian`, but the byte swap happens on little-endian
+ * hosts.
  */
-struct big_endian : public endian_base {
+struct big_endian
+    : public endian_base
+    , public details::bit_cast_codec<big_endian>
+    , public details::packed_codec<true>
+    , public details::array_codec<ENCODING_BINARY_HOST_LITTLE_ENDIAN> {
     using endian_base::encode;
     using endian_base::decode;
+    using details::bit_cast_codec<big_endian>::encode;
+    using details::bit_cast_codec<big_endian>::decode;
+    using details::packed_codec<true>::encode;
+    using details::packed_codec<true>::decode;
 
-    static void encode(uint16_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val >> 8);
-        buf[1] = uint8_t(val);
-    }
-    static void decode(const uint8_t *buf, uint16_t &val) {
-        val = uint16_t(buf[0] << 8) | buf[1];
-    }
-    static void encode(uint32_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val >> 24);
-        buf[1] = uint8_t(val >> 16);
-        buf[2] = uint8_t(val >> 8);
-        buf[3] = uint8_t(val);
-    }
-    static void decode(const uint8_t *buf, uint32_t &val) {
-        val = uint32_t(buf[0]) << 24 |
-            uint32_t(buf[1]) << 16 |
-            uint32_t(buf[2]) << 8 |
-            buf[3];
-    }
-    static void encode(uint64_t val, uint8_t *buf) {
-        buf[0] = uint8_t(val >> 56);
-        buf[1] = uint8_t(val >> 48);
-        buf[2] = uint8_t(val >> 40);
-        buf[3] = uint8_t(val >> 32);
-        buf[4] = uint8_t(val >> 24);
-        buf[5] = uint8_t(val >> 16);
-        buf[6] = uint8_t(val >> 8);
-        buf[7] = uint8_t(val);
-    }
-    static void decode(const uint8_t *buf, uint64_t &val) {
-        val = uint64_t(buf[0]) << 56 |
-            uint64_t(buf[1]) << 48 |
-            uint64_t(buf[2]) << 40 |
-            uint64_t(buf[3]) << 32 |
-            uint64_t(buf[4]) << 24 |
-            uint64_t(buf[5]) << 16 |
-            uint64_t(buf[6]) << 8 |
-            buf[7];
+    ENCODING_BINARY_CONSTEXPR static void encode(uint16_t val, uint8_t *buf) {
+        details::store(details::to_big(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint16_t &val) {
+        val = details::to_big(details::load<uint16_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint32_t val, uint8_t *buf) {
+        details::store(details::to_big(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint32_t &val) {
+        val = details::to_big(details::load<uint32_t>(buf));
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint64_t val, uint8_t *buf) {
+        details::store(details::to_big(val), buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint64_t &val) {
+        val = details::to_big(details::load<uint64_t>(buf));
     }
 };
 
 /**
  * @brief Implementation of native encoding routines. This
  * implementation usually the fastest one, but it's not portable.
+ *
+ * Values may be placed at any offset: every access is a well-defined
+ * unaligned load or store, which is a single move on mainstream CPUs.
  */
-struct native_endian : public endian_base {
+struct native_endian
+    : public endian_base
+    , public details::bit_cast_codec<native_endian>
+    , public details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>
+    , public details::array_codec<false> {
     using endian_base::encode;
     using endian_base::decode;
+    using details::bit_cast_codec<native_endian>::encode;
+    using details::bit_cast_codec<native_endian>::decode;
+    using details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>::encode;
+    using details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>::decode;
 
-    static void encode(uint16_t val, uint8_t *buf) {
-        *reinterpret_cast<uint16_t*>(buf) = val;
+    ENCODING_BINARY_CONSTEXPR static void encode(uint16_t val, uint8_t *buf) {
+        details::store(val, buf);
     }
-    static void decode(const uint8_t *buf, uint16_t &val) {
-        val = *reinterpret_cast<const uint16_t*>(buf);
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint16_t &val) {
+        val = details::load<uint16_t>(buf);
     }
-    static void encode(uint32_t val, uint8_t *buf) {
-        *reinterpret_cast<uint32_t*>(buf) = val;
+    ENCODING_BINARY_CONSTEXPR static void encode(uint32_t val, uint8_t *buf) {
+        details::store(val, buf);
     }
-    static void decode(const uint8_t *buf, uint32_t &val) {
-        val = *reinterpret_cast<const uint32_t*>(buf);
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint32_t &val) {
+        val = details::load<uint32_t>(buf);
     }
-    static void encode(uint64_t val, uint8_t *buf) {
-        *reinterpret_cast<uint64_t*>(buf) = val;
+    ENCODING_BINARY_CONSTEXPR static void encode(uint64_t val, uint8_t *buf) {
+        details::store(val, buf);
     }
-    static void decode(const uint8_t *buf, uint64_t &val) {
-        val = *reinterpret_cast<const uint64_t*>(buf);
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint64_t &val) {
+        val = details::load<uint64_t>(buf);
+    }
+};
+
+/**
+ * @brief Native encoding routines for naturally aligned data.
+ *
+ * Produces the same bytes as `native_endian`, but the caller
+ * guarantees that every value of type `T` lives at an address that
+ * is a multiple of `sizeof(T)`. It allows the compiler to emit
+ * aligned (vector) moves in bulk loops. Using it on misaligned data
+ * is undefined behavior.
+ */
+struct aligned_native_endian
+    : public endian_base
+    , public details::bit_cast_codec<aligned_native_endian>
+    , public details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>
+    , public details::array_codec<false> {
+    using endian_base::encode;
+    using endian_base::decode;
+    using details::bit_cast_codec<aligned_native_endian>::encode;
+    using details::bit_cast_codec<aligned_native_endian>::decode;
+    using details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>::encode;
+    using details::packed_codec<ENCODING_BINARY_HOST_BIG_ENDIAN>::decode;
+
+    ENCODING_BINARY_CONSTEXPR static void encode(uint16_t val, uint8_t *buf) {
+        details::store_aligned(val, buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint16_t &val) {
+        val = details::load_aligned<uint16_t>(buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint32_t val, uint8_t *buf) {
+        details::store_aligned(val, buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint32_t &val) {
+        val = details::load_aligned<uint32_t>(buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void encode(uint64_t val, uint8_t *buf) {
+        details::store_aligned(val, buf);
+    }
+    ENCODING_BINARY_CONSTEXPR static void decode(const uint8_t *buf, uint64_t &val) {
+        val = details::load_aligned<uint64_t>(buf);
     }
 };
 
 /** @} */
 
+/**
+ * @brief Fixed-size byte sequence that can be filled in a constant
+ * expression and then put into a buffer with a single copy.
+ *
+ * With C++14 and a compiler that provides
+ * `__builtin_is_constant_evaluated` (see
+ * `ENCODING_BINARY_HAS_CONSTEXPR_ENCODING`), static buffers and
+ * integer encoding routines are `constexpr`, so constant message
+ * prefixes can be encoded during compilation:
+ *
+ *     constexpr bin::byte_array<6> make_preamble() {
+ *         bin::byte_array<6> bytes = {};
+ *         bin::writeonly_static_buffer<6>(bytes.data)
+ *             .put(uint32_t(0xcafebabe)).put(uint16_t(3));
+ *         return bytes;
+ *     }
+ *     constexpr bin::byte_array<6> Preamble = make_preamble();
+ */
+template <std::size_t Size>
+struct byte_array {
+    uint8_t data[Size];
+
+    ENCODING_BINARY_CONSTEXPR std::size_t size() const { return Size; }
+};
+
+/**
+ * @brief Non-owning view of a byte sequence inside a buffer, returned
+ * by `get_blob`. It stays valid as long as the underlying memory.
+ */
+class byte_view {
+public:
+    typedef const uint8_t *const_iterator;
+
+    byte_view() : data_(0), size_(0) {}
+
+    byte_view(const uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    const uint8_t * data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    bool operator==(const byte_view &other) const
+    {
+        return size_ == other.size_ && (size_ == 0 || std::memcmp(data_, other.data_, size_) == 0);
+    }
+
+    bool operator!=(const byte_view &other) const { return !(*this == other); }
+
+private:
+    const uint8_t *data_;
+    std::size_t size_;
+};
+
+/**
+ * @brief Prefix type of `put_blob`/`get_blob` that stores the length
+ * as an unsigned LEB128 varint.
+ */
+struct varint_prefix {};
+
+namespace details {
+
+/**
+ * @brief Length prefix codec of blobs. Defined for `uint8_t`,
+ * `uint16_t`, `uint32_t`, `uint64_t`, `packed_uint` and
+ * `varint_prefix`.
+ */
+template <typename Prefix> struct blob_prefix;
+
+template <typename T>
+struct fixed_blob_prefix {
+    static bool fits(std::size_t length) { return length <= std::size_t(T(~T(0))); }
+    static std::size_t size(std::size_t) { return sizeof(T); }
+
+    template <typename BufferType>
+    static void put(BufferType &buf, std::size_t length) { buf.put(T(length)); }
+
+    template <typename BufferType>
+    static void get(BufferType &buf, uint64_t &length)
+    {
+        T prefix = 0;
+        buf.get(prefix);
+        length = prefix;
+    }
+};
+
+template <> struct blob_prefix<uint8_t> : fixed_blob_prefix<uint8_t> {};
+template <> struct blob_prefix<uint16_t> : fixed_blob_prefix<uint16_t> {};
+template <> struct blob_prefix<uint32_t> : fixed_blob_prefix<uint32_t> {};
+template <> struct blob_prefix<uint64_t> : fixed_blob_prefix<uint64_t> {};
+
+template <typename S, std::size_t N>
+struct blob_prefix< packed_uint<S, N> > {
+    static bool fits(std::size_t length)
+    {
+        return N >= sizeof(std::size_t) || length >> (8 * N % (8 * sizeof(std::size_t))) == 0;
+    }
+    static std::size_t size(std::size_t) { return N; }
+
+    template <typename BufferType>
+    static void put(BufferType &buf, std::size_t length) { buf.put(packed_uint<S, N>(S(length))); }
+
+    template <typename BufferType>
+    static void get(BufferType &buf, uint64_t &length)
+    {
+        packed_uint<S, N> prefix;
+        buf.get(prefix);
+        length = prefix.value;
+    }
+};
+
+template <> struct blob_prefix<varint_prefix> {
+    static bool fits(std::size_t) { return true; }
+    static std::size_t size(std::size_t length) { return varint_size(length); }
+
+    template <typename BufferType>
+    static void put(BufferType &buf, std::size_t length) { buf.put_varint(uint64_t(length)); }
+
+    template <typename BufferType>
+    static void get(BufferType &buf, uint64_t &length) { buf.get_varint(length); }
+};
+
+}
+
+/**
+ * @brief Handle of a field reserved by `put_placeholder` and filled in
+ * later by `fill` or `fill_length`. It keeps the offset of the field,
+ * so it stays valid when a growable buffer reallocates.
+ * @tparam T field type
+ */
+template <typename T>
+struct placeholder {
+    std::size_t offset;
+};
+
+namespace details {
+
+/**
+ * @brief Tells whether a placeholder lies within the first `written`
+ * bytes of a buffer.
+ */
+template <typename T>
+bool placeholder_fits(placeholder<T> field, std::size_t written)
+{
+    return field.offset <= written && written - field.offset >= wire_size<T>::value;
+}
+
+/**
+ * @brief Returns number of bytes written after a placeholder.
+ */
+template <typename T>
+std::size_t placeholder_length(placeholder<T> field, std::size_t written)
+{
+    return written - field.offset - wire_size<T>::value;
+}
+
+}
+
 /**
  * @defgroup ACTraits Access Control Traits
  * @{
@@ -230,6 +635,215 @@ struct access_traits<read_access_tag> {
 
 /** @} */
 
+/**
+ * @brief Unchecked cursor over a window of a buffer that was
+ * bounds-checked once by `basic_buffer::reserve` or
+ * `basic_buffer::require`.
+ *
+ * Operations on a window don't check bounds: the caller promises not
+ * to move past the reserved bytes. The owner's position is updated
+ * once, when the window is destroyed, so a record encoded through a
+ * window costs one check and one position update. The buffer must
+ * not be used while the window is alive.
+ *
+ *     buf.reserve(12).put(uint32_t(id)).put(uint64_t(stamp));
+ *
+ * @tparam ByteOrder byte order used for encoding
+ * @tparam AccessTag type tag that restricts operations on window
+ */
+template <
+    typename ByteOrder,
+    typename AccessTag
+    >
+class basic_window
+{
+public:
+    typedef ByteOrder byte_order;
+    typedef AccessTag access_tag;
+    typedef typename access_traits<access_tag>::value_type value_type;
+    typedef typename access_traits<access_tag>::iterator iterator;
+    typedef typename access_traits<access_tag>::const_iterator const_iterator;
+
+    /**
+     * @brief Creates a window of `length` bytes starting at `pos`.
+     * The bytes must be available; `pos` is set to the window
+     * position on destruction.
+     */
+    basic_window(iterator &pos, std::size_t length)
+        : owner_(&pos)
+        , pos_(pos)
+        , end_(pos + length)
+    {}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+    /**
+     * @brief Takes over the owner's position from another window,
+     * which no longer updates it.
+     */
+    basic_window(basic_window &&other)
+        : owner_(other.owner_)
+        , pos_(other.pos_)
+        , end_(other.end_)
+    {
+        other.owner_ = 0;
+    }
+
+    basic_window & operator=(basic_window &&other)
+    {
+        if (this != &other) {
+            commit();
+            owner_ = other.owner_;
+            pos_ = other.pos_;
+            end_ = other.end_;
+            other.owner_ = 0;
+        }
+        return *this;
+    }
+
+    basic_window(const basic_window &) = delete;
+    basic_window & operator=(const basic_window &) = delete;
+#else
+    // Without move semantics a copy transfers ownership like
+    // `std::auto_ptr`, so the position is still committed once.
+    basic_window(const basic_window &other)
+        : owner_(other.owner_)
+        , pos_(other.pos_)
+        , end_(other.end_)
+    {
+        other.owner_ = 0;
+    }
+#endif
+
+    ~basic_window() { commit(); }
+
+    /**
+     * @brief Returns position of a window.
+     */
+    const_iterator pos() const { return pos_; }
+
+    /**
+     * @brief Returns end of a window.
+     */
+    const_iterator end() const { return end_; }
+
+    /**
+     * @brief Returns number of bytes left in a window.
+     */
+    std::size_t bytes_left() const { return end_ - pos_; }
+
+    /**
+     * @brief Puts a value without checking bounds.
+     * @return current window
+     */
+    template <typename T>
+    basic_window & put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Puts a value using given byte order without checking
+     * bounds.
+     * @return current window
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_window &>::type
+    put(T value)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        Order::encode(value, pos_);
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Copies sequence of bytes without checking bounds.
+     * @return current window
+     */
+    basic_window & put(const value_type *from, std::size_t length)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        std::memcpy(pos_, from, length);
+        pos_ += length;
+        return *this;
+    }
+
+    /**
+     * @brief Copies a fixed-size byte array without checking bounds.
+     * @return current window
+     */
+    template <std::size_t Length>
+    basic_window & put(const byte_array<Length> &bytes)
+    {
+        return put(bytes.data, Length);
+    }
+
+    /**
+     * @brief Reads a value without checking bounds.
+     * @return current window
+     */
+    template <typename T>
+    basic_window & get(T &value)
+    {
+        return get<byte_order>(value);
+    }
+
+    /**
+     * @brief Reads a value using given byte order without checking
+     * bounds.
+     * @return current window
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_window &>::type
+    get(T &value)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        details::slack_decoder<T>::template decode<Order>(pos_, bytes_left(), value);
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Reads a sequence of bytes without checking bounds.
+     * @return current window
+     */
+    basic_window & get(value_type *dst, std::size_t length)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        std::memcpy(dst, pos_, length);
+        pos_ += length;
+        return *this;
+    }
+
+    /**
+     * @brief Skips `count` bytes without checking bounds.
+     * @return current window
+     */
+    basic_window & skip(std::size_t count)
+    {
+        pos_ += count;
+        return *this;
+    }
+
+private:
+#if !ENCODING_BINARY_HAS_RVALUE_REFERENCES
+    basic_window & operator=(const basic_window &);
+#endif
+
+    void commit()
+    {
+        if (owner_) *owner_ = pos_;
+    }
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+    iterator *owner_;
+#else
+    mutable iterator *owner_;
+#endif
+    iterator pos_;
+    const_iterator end_;
+};
+
 /**
  * @brief Implementation of bound binary buffer.
  *
@@ -241,16 +855,20 @@ struct access_traits<read_access_tag> {
  *
  * @tparam ByteOrder byte order used for encoding
  * @tparam AccessTag type tag that restricts operations on buffer
+ * @tparam OverflowPolicy what to do when an operation doesn't fit,
+ * see overflow.h
  */
 template <
     typename ByteOrder = default_byte_order,
-    typename AccessTag = read_write_access_tag
+    typename AccessTag = read_write_access_tag,
+    typename OverflowPolicy
     >
-class basic_buffer
+class basic_buffer : public OverflowPolicy
 {
 public:
     typedef ByteOrder byte_order;
     typedef AccessTag access_tag;
+    typedef OverflowPolicy overflow_policy;
     typedef typename access_traits<access_tag>::value_type value_type;
     typedef typename access_traits<access_tag>::strict_type strict_type;
     typedef typename access_traits<access_tag>::iterator iterator;
@@ -276,104 +894,403 @@ public:
     {}
 
     /**
-     * @brief Returns beginning of a buffer.
+     * @brief Returns beginning of a buffer.
+     */
+    const_iterator begin() const { return begin_; }
+    iterator begin() { return begin_; }
+
+    /**
+     * @brief Returns end of a buffer.
+     */
+    const_iterator end() const { return end_; }
+
+    /**
+     * @brief Returns position of a buffer.
+     */
+    const_iterator pos() const { return pos_; }
+    iterator pos() { return pos_; }
+
+    /**
+     * @brief Returns total size of buffer in bytes.
+     */
+    std::size_t size() const { return end() - begin(); }
+
+    /**
+     * @brief Returns number of not consumed/written bytes from input
+     * sequence.
+     */
+    std::size_t bytes_left() const { return end() - pos(); }
+
+    /**
+     * @brief Resets buffer position to begin.
+     * @return current buffer
+     */
+    basic_buffer & reset()
+    {
+        pos_ = begin();
+        return *this;
+    }
+
+    /**
+     * @brief Retargets buffer to a new range and resets the position.
+     * State of the overflow policy is kept.
+     * @return current buffer
+     */
+    basic_buffer & assign(iterator begin, iterator end)
+    {
+        begin_ = pos_ = begin;
+        end_ = end;
+        return *this;
+    }
+
+    basic_buffer & assign(iterator begin, std::size_t length)
+    {
+        return assign(begin, begin + length);
+    }
+
+    /**
+     * @brief Returns the position as an offset from the beginning, to
+     * be passed to `restore` later. Marks stay meaningful when the
+     * buffer is retargeted to a range with the same contents, e.g. a
+     * receive buffer that was grown or moved.
+     */
+    std::size_t mark() const { return std::size_t(pos_ - begin_); }
+
+    /**
+     * @brief Moves the position back (or forward) to a mark.
+     * @param mark value returned by `mark`
+     * @return current buffer
+     */
+    basic_buffer & restore(std::size_t mark)
+    {
+        if (ENCODING_BINARY_UNLIKELY(mark > size())) return overflow();
+        pos_ = begin_ + mark;
+        return *this;
+    }
+
+    /**
+     * @brief Puts a value into a buffer.
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_buffer & put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Puts a value into a buffer using given byte order instead
+     * of the buffer's one. Handy for mixed-endian records.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_buffer &>::type
+    put(T value)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < wire_size<T>::value)) return overflow();
+        Order::encode(value, pos());
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Copies sequence of bytes into a buffer. Nothing is written
+     * if the sequence doesn't fit.
+     * @param from input sequence begin
+     * @param length length of the input sequence
+     * @return current buffer
+     */
+    basic_buffer & put(const value_type *from, std::size_t length)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) return overflow();
+        details::copy_sequence(pos_, from, length);
+        pos_ += length;
+        return *this;
+    }
+
+    /**
+     * @brief Copies a fixed-size byte array into a buffer.
+     * @tparam Length length of the array
+     * @return current buffer
      */
-    const_iterator begin() const { return begin_; }
-    iterator begin() { return begin_; }
+    template <std::size_t Length>
+    basic_buffer & put(const byte_array<Length> &bytes)
+    {
+        return put(bytes.data, Length);
+    }
 
     /**
-     * @brief Returns end of a buffer.
+     * @brief Puts an array of values into a buffer. Bounds are checked
+     * once and the byte order conversion runs over the whole array.
+     * @tparam T value type
+     * @param values pointer to the first value
+     * @param count number of values to put
+     * @return current buffer
      */
-    const_iterator end() const { return end_; }
+    template <typename T>
+    basic_buffer & put_array(const T *values, std::size_t count)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() / sizeof(T) < count)) return overflow();
+        byte_order::encode_array(values, count, pos());
+        pos_ += count * sizeof(T);
+        return *this;
+    }
 
     /**
-     * @brief Returns position of a buffer.
+     * @brief Reads a value from a buffer.
+     * @tparam T value type
+     * @param value reference to value
+     * @return current buffer
      */
-    const_iterator pos() const { return pos_; }
-    iterator pos() { return pos_; }
+    template <typename T>
+    basic_buffer & get(T &value)
+    {
+        return get<byte_order>(value);
+    }
 
     /**
-     * @brief Returns total size of buffer in bytes.
+     * @brief Reads a value from a buffer using given byte order instead
+     * of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value reference to value
+     * @return current buffer
      */
-    std::size_t size() const { return end() - begin(); }
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_buffer &>::type
+    get(T &value)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < wire_size<T>::value)) return overflow();
+        details::slack_decoder<T>::template decode<Order>(pos(), bytes_left(), value);
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
 
     /**
-     * @brief Returns number of not consumed/written bytes from input
-     * sequence.
+     * @brief Reads a value at the current position without moving it.
+     * @tparam T value type
+     * @return value, or `T()` if it doesn't fit and the overflow
+     * policy returns
      */
-    std::size_t bytes_left() const { return end() - pos(); }
+    template <typename T>
+    T peek()
+    {
+        return read_at<T>(std::size_t(pos() - begin()));
+    }
 
     /**
-     * @brief Resets buffer position to begin.
+     * @brief Reads a value at `offset` bytes from the beginning of a
+     * buffer without moving the position.
+     * @tparam T value type
+     * @param offset offset of the value
+     * @return value, or `T()` if it doesn't fit and the overflow
+     * policy returns
+     */
+    template <typename T>
+    T read_at(std::size_t offset)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        T value = T();
+        if (ENCODING_BINARY_UNLIKELY(offset > size() || size() - offset < wire_size<T>::value)) {
+            overflow_policy::on_overflow();
+            return value;
+        }
+        details::slack_decoder<T>::template decode<byte_order>(begin_ + offset, size() - offset, value);
+        return value;
+    }
+
+    /**
+     * @brief Reads a sequence of bytes from a buffer.
+     * @param dst destination byte sequence
+     * @param length length of the output sequence
      * @return current buffer
      */
-    basic_buffer & reset()
+    basic_buffer & get(value_type *dst, std::size_t length)
     {
-        pos_ = begin();
+        details::assert_access<read_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) return overflow();
+        std::memcpy(dst, pos_, length);
+        pos_ += length;
         return *this;
     }
 
     /**
-     * @brief Puts a value into a buffer.
+     * @brief Reads an array of values from a buffer.
      * @tparam T value type
+     * @param values pointer to the first value of destination array
+     * @param count number of values to read
+     * @return current buffer
+     */
+    template <typename T>
+    basic_buffer & get_array(T *values, std::size_t count)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() / sizeof(T) < count)) return overflow();
+        byte_order::decode_array(pos(), count, values);
+        pos_ += count * sizeof(T);
+        return *this;
+    }
+
+    /**
+     * @brief Puts an unsigned LEB128 varint into a buffer.
+     * @tparam T value type, `uint32_t` or `uint64_t`
      * @param value value to put
      * @return current buffer
      */
     template <typename T>
-    basic_buffer & put(T value)
+    basic_buffer & put_varint(T value)
     {
         details::assert_access<write_access_tag>(access_tag());
-        if (bytes_left() < sizeof(value)) throw Overflow;
-        byte_order::encode(value, pos());
-        pos_ += sizeof(value);
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < details::varint_traits<T>::max_size)
+            && bytes_left() < details::varint_size(value)) {
+            return overflow();
+        }
+        pos_ += details::encode_varint(value, pos_);
+        return *this;
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint from a buffer. Varints
+     * that are too long or don't fit `T` are reported as malformed.
+     * @tparam T value type, `uint32_t` or `uint64_t`
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename T>
+    basic_buffer & get_varint(T &value)
+    {
+        read_varint(value);
+        return *this;
+    }
+
+    /**
+     * @brief Puts a signed value as a ZigZag-encoded varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_buffer & put_svarint(T value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        return put_varint(details::zigzag_encode(bits(value)));
+    }
+
+    /**
+     * @brief Reads a ZigZag-encoded signed varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename T>
+    basic_buffer & get_svarint(T &value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        bits zigzag = 0;
+        if (read_varint(zigzag)) value = T(details::zigzag_decode(zigzag));
         return *this;
     }
 
     /**
-     * @brief Copies sequence of bytes into a buffer.
+     * @brief Puts a byte sequence preceded by its length.
+     * @tparam Prefix length type: `uint8_t`, `uint16_t`, `uint32_t`,
+     * `uint64_t`, `packed_uint` or `varint_prefix`
      * @param from input sequence begin
      * @param length length of the input sequence
      * @return current buffer
      */
-    basic_buffer & put(const value_type *from, std::size_t length)
+    template <typename Prefix>
+    basic_buffer & put_blob(const value_type *from, std::size_t length)
     {
         details::assert_access<write_access_tag>(access_tag());
-        const const_iterator to = from + length;
-        for (; from != to && pos_ != end_; ++pos_, ++from) {
-            *pos_ = *from;
+        typedef details::blob_prefix<Prefix> prefix;
+        if (ENCODING_BINARY_UNLIKELY(!prefix::fits(length)
+                                     || bytes_left() < length
+                                     || bytes_left() - length < prefix::size(length))) {
+            return overflow();
         }
-        if (from != to) throw Overflow;
-        return *this;
+        prefix::put(*this, length);
+        return put(from, length);
     }
 
     /**
-     * @brief Reads a value from a buffer.
-     * @tparam T value type
-     * @param value reference to value
+     * @brief Reserves a zeroed field to be filled in later, e.g. with a
+     * length or a checksum of what follows.
+     * @tparam T field type
+     * @return handle of the field
+     */
+    template <typename T>
+    placeholder<T> put_placeholder()
+    {
+        placeholder<T> field = { std::size_t(pos_ - begin_) };
+        put(T());
+        return field;
+    }
+
+    /**
+     * @brief Writes a value into a reserved field. Position doesn't
+     * change.
+     * @tparam T field type
+     * @param field handle returned by `put_placeholder`
+     * @param value value to write
      * @return current buffer
      */
     template <typename T>
-    basic_buffer & get(T &value)
+    basic_buffer & fill(placeholder<T> field, T value)
     {
-        details::assert_access<read_access_tag>(access_tag());
-        if (bytes_left() < sizeof(value)) throw Overflow;
-        byte_order::decode(pos(), value);
-        pos_ += sizeof(value);
+        details::assert_access<write_access_tag>(access_tag());
+        if (ENCODING_BINARY_UNLIKELY(!details::placeholder_fits(field, std::size_t(pos_ - begin_)))) {
+            overflow_policy::on_overflow();
+            return *this;
+        }
+        byte_order::encode(value, begin_ + field.offset);
         return *this;
     }
 
     /**
-     * @brief Reads a sequence of bytes from a buffer.
-     * @param dst destination byte sequence
-     * @param length length of the output sequence
+     * @brief Writes number of bytes put after a reserved field into
+     * the field. A length that doesn't fit `T` is an overflow.
+     * @tparam T field type, an unsigned integer or `packed_uint`
+     * @param field handle returned by `put_placeholder`
      * @return current buffer
      */
-    basic_buffer & get(value_type *dst, std::size_t length)
+    template <typename T>
+    basic_buffer & fill_length(placeholder<T> field)
+    {
+        const std::size_t written = std::size_t(pos_ - begin_);
+        if (ENCODING_BINARY_UNLIKELY(!details::placeholder_fits(field, written)
+                                     || !details::blob_prefix<T>::fits(details::placeholder_length(field, written)))) {
+            overflow_policy::on_overflow();
+            return *this;
+        }
+        return fill(field, T(details::placeholder_length(field, written)));
+    }
+
+    /**
+     * @brief Reads a length-prefixed byte sequence without copying it.
+     * @tparam Prefix length type used by `put_blob`
+     * @param view view of the sequence inside the buffer, left
+     * untouched on failure
+     * @return current buffer
+     */
+    template <typename Prefix>
+    basic_buffer & get_blob(byte_view &view)
     {
         details::assert_access<read_access_tag>(access_tag());
-        if (bytes_left() < length) throw Overflow;
-        std::memcpy(dst, pos_, length);
-        pos_ += length;
+        uint64_t length = 0;
+        if (ENCODING_BINARY_UNLIKELY(!read_prefix(length, static_cast<Prefix*>(0)))) return *this;
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) return overflow();
+        view = byte_view(pos(), std::size_t(length));
+        pos_ += std::size_t(length);
         return *this;
     }
 
@@ -386,14 +1303,137 @@ public:
      */
     basic_buffer & skip(std::size_t count)
     {
-        if (bytes_left() < count) throw Overflow;
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < count)) return overflow();
         pos_ += count;
         return *this;
     }
 
+    /**
+     * @brief Splits off the next `length` bytes as a separate buffer
+     * and moves past them. Nested decoders get tight bounds without
+     * copying.
+     * @param length length of the slice
+     * @return buffer over the slice, empty if it doesn't fit
+     */
+    basic_buffer slice(std::size_t length)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) {
+            overflow();
+            return basic_buffer(pos_, std::size_t(0));
+        }
+        const iterator from = pos_;
+        pos_ += length;
+        return basic_buffer(from, length);
+    }
+
+    /**
+     * @brief Splits off the next `Length` bytes as a static buffer and
+     * moves past them. Available only with policies that stop on
+     * overflow.
+     * @tparam Length length of the slice
+     * @return static buffer over the slice
+     */
+    template <std::size_t Length>
+    basic_static_buffer<byte_order, access_tag, Length, 0u> slice()
+    {
+        (void) sizeof(details::static_check<overflow_policy::stops_on_overflow>);
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < Length)) overflow_policy::on_overflow();
+        const iterator from = pos_;
+        pos_ += Length;
+        return basic_static_buffer<byte_order, access_tag, Length, 0u>(from);
+    }
+
+    /**
+     * @brief Checks once that `length` bytes can be written and
+     * returns an unchecked window over them. Buffer position moves
+     * when the window is destroyed. Available only with policies
+     * that stop on overflow.
+     * @param length number of bytes to reserve
+     * @return window over the reserved bytes
+     */
+    basic_window<byte_order, access_tag> reserve(std::size_t length)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        (void) sizeof(details::static_check<overflow_policy::stops_on_overflow>);
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) overflow_policy::on_overflow();
+        return basic_window<byte_order, access_tag>(pos_, length);
+    }
+
+    /**
+     * @brief Checks once that `length` bytes can be read and returns
+     * an unchecked window over them. Buffer position moves when the
+     * window is destroyed. Available only with policies that stop on
+     * overflow.
+     * @param length number of bytes to require
+     * @return window over the required bytes
+     */
+    basic_window<byte_order, access_tag> require(std::size_t length)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        (void) sizeof(details::static_check<overflow_policy::stops_on_overflow>);
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) overflow_policy::on_overflow();
+        return basic_window<byte_order, access_tag>(pos_, length);
+    }
+
 private:
-    const iterator begin_;     // not const_iterator to allow assignment `pos_ = begin_`
-    const const_iterator end_;
+    // Prefix readers of `get_blob`. Return false if the prefix was
+    // reported as an overflow or as malformed.
+    template <typename Prefix>
+    bool read_prefix(uint64_t &length, Prefix *)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < details::blob_prefix<Prefix>::size(0))) {
+            overflow();
+            return false;
+        }
+        details::blob_prefix<Prefix>::get(*this, length);
+        return true;
+    }
+
+    bool read_prefix(uint64_t &length, varint_prefix *)
+    {
+        return read_varint(length);
+    }
+
+    // Returns false if the varint was reported as an overflow or as
+    // malformed.
+    template <typename T>
+    bool read_varint(T &value)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        std::size_t size;
+        if (bytes_left() >= details::varint_fast_bytes) {
+            size = details::decode_varint_fast(pos(), value);
+        } else {
+            size = details::decode_varint_slow(pos(), bytes_left(), value);
+            if (ENCODING_BINARY_UNLIKELY(size == 0)) {
+                overflow();
+                return false;
+            }
+        }
+        if (ENCODING_BINARY_UNLIKELY(size == details::varint_malformed)) {
+            malformed();
+            return false;
+        }
+        pos_ += size;
+        return true;
+    }
+
+    basic_buffer & overflow()
+    {
+        overflow_policy::on_overflow();
+        pos_ += bytes_left();
+        return *this;
+    }
+
+    basic_buffer & malformed()
+    {
+        overflow_policy::on_malformed();
+        pos_ += bytes_left();
+        return *this;
+    }
+
+    iterator begin_;     // not const_iterator to allow assignment `pos_ = begin_`
+    const_iterator end_;
     iterator pos_;
 };
 
@@ -433,37 +1473,37 @@ public:
     typedef typename access_traits<access_tag>::iterator iterator;
     typedef typename access_traits<access_tag>::const_iterator const_iterator;
 
-    basic_static_buffer(iterator begin)
+    ENCODING_BINARY_CONSTEXPR basic_static_buffer(iterator begin)
         : begin_(begin)
     {}
 
     /**
      * @brief Returns pointer to first element of the buffer.
      */
-    const_iterator begin() const { return begin_; }
-    iterator begin() { return begin_; }
+    ENCODING_BINARY_CONSTEXPR const_iterator begin() const { return begin_; }
+    ENCODING_BINARY_CONSTEXPR iterator begin() { return begin_; }
 
     /**
      * @brief Returns end of a buffer (pointer to element after the
      * last one).
      */
-    const_iterator end() const { return begin_ + Size; }
+    ENCODING_BINARY_CONSTEXPR const_iterator end() const { return begin_ + Size; }
 
     /**
      * @brief Returns current position in a buffer.
      */
-    const_iterator pos() const { return begin_ + Offset; }
-    iterator pos() { return begin_ + Offset; }
+    ENCODING_BINARY_CONSTEXPR const_iterator pos() const { return begin_ + Offset; }
+    ENCODING_BINARY_CONSTEXPR iterator pos() { return begin_ + Offset; }
 
     /**
      * @brief Returns size of a buffer.
      */
-    std::size_t size() const { return Size; }
+    ENCODING_BINARY_CONSTEXPR std::size_t size() const { return Size; }
 
     /**
      * @brief Returns number bytes left to the end, synonym to `end() - pos()`.
      */
-    std::size_t bytes_left() const { return Size - Offset; }
+    ENCODING_BINARY_CONSTEXPR std::size_t bytes_left() const { return Size - Offset; }
 
     /**
      * @brief Reads a value from a buffer.
@@ -471,14 +1511,59 @@ public:
      * @return new buffer with updated offset
      */
     template <typename T>
-    typename details::enable_if<
-        sizeof(T) <= (Size - Offset),
-        basic_static_buffer<byte_order, access_tag, Size, Offset + sizeof(T)>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        wire_size<T>::value <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>
+        >::type get(T &value)
+    {
+        return get<byte_order>(value);
+    }
+
+    /**
+     * @brief Reads a value from a buffer using given byte order instead
+     * of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @return new buffer with updated offset
+     */
+    template <typename Order, typename T>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        details::is_byte_order<Order>::value && wire_size<T>::value <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>
         >::type get(T &value)
     {
         details::assert_access<read_access_tag>(access_tag());
-        byte_order::decode(begin_ + Offset, value);
-        return basic_static_buffer<byte_order, access_tag, Size, Offset + sizeof(T)>(begin_);
+        details::slack_decoder<T>::template decode<Order>(begin_ + Offset, Size - Offset, value);
+        return basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>(begin_);
+    }
+
+    /**
+     * @brief Reads a value at the current position without moving it.
+     * @tparam T value type
+     * @return value
+     */
+    template <typename T>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        wire_size<T>::value <= (Size - Offset), T
+        >::type peek() const
+    {
+        return read<T>(Offset);
+    }
+
+    /**
+     * @brief Reads a value at offset `At` from the beginning of a
+     * buffer without moving the position. The offset is checked at
+     * compile time.
+     * @tparam T value type
+     * @tparam At offset of the value
+     * @return value
+     */
+    template <typename T, std::size_t At>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        (At <= Size && wire_size<T>::value <= Size - At), T
+        >::type read_at() const
+    {
+        return read<T>(At);
     }
 
      /**
@@ -487,16 +1572,33 @@ public:
      * @return new buffer with updated offset
      */
     template <std::size_t Length>
-    typename details::enable_if<
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
         Length <= (Size - Offset),
         basic_static_buffer<byte_order, access_tag, Size, Offset + Length>
         >::type get(value_type *dst)
     {
         details::assert_access<read_access_tag>(access_tag());
-        std::memcpy(dst, pos(), Length);
+        details::copy_bytes(dst, pos(), Length);
         return basic_static_buffer<byte_order, access_tag, Size, Offset + Length>(begin());
     }
 
+    /**
+     * @brief Reads an array of values from a buffer.
+     * @tparam Count number of values to read
+     * @tparam T value type
+     * @return new buffer with updated offset
+     */
+    template <std::size_t Count, typename T>
+    typename details::enable_if<
+        Count * sizeof(T) <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + Count * sizeof(T)>
+        >::type get_array(T *values)
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        byte_order::decode_array(pos(), Count, values);
+        return basic_static_buffer<byte_order, access_tag, Size, Offset + Count * sizeof(T)>(begin());
+    }
+
     /**
      * @brief Writes a value into a buffer.
      * @tparam T value type
@@ -504,14 +1606,31 @@ public:
      * @return new buffer with updated offset
      */
     template <typename T>
-    typename details::enable_if<
-        sizeof(T) <= (Size - Offset),
-        basic_static_buffer<byte_order, access_tag, Size, Offset + sizeof(T)>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        wire_size<T>::value <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>
+        >::type put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Writes a value into a buffer using given byte order
+     * instead of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value value to put
+     * @return new buffer with updated offset
+     */
+    template <typename Order, typename T>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        details::is_byte_order<Order>::value && wire_size<T>::value <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>
         >::type put(T value)
     {
         details::assert_access<write_access_tag>(access_tag());
-        byte_order::encode(value, pos());
-        return basic_static_buffer<byte_order, access_tag, Size, Offset + sizeof(T)>(begin());
+        Order::encode(value, pos());
+        return basic_static_buffer<byte_order, access_tag, Size, Offset + wire_size<T>::value>(begin());
     }
 
     /**
@@ -520,40 +1639,100 @@ public:
      * @return new buffer with updated offset
      */
     template <std::size_t Length>
-    typename details::enable_if<
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
         Length <= (Size - Offset),
         basic_static_buffer<byte_order, access_tag, Size, Offset + Length>
         >::type put(const_iterator bytes)
     {
         details::assert_access<write_access_tag>(access_tag());
-        std::memcpy(pos(), bytes, Length);
+        details::copy_bytes(pos(), bytes, Length);
         return basic_static_buffer<byte_order, access_tag, Size, Offset + Length>(begin());
     }
 
+    /**
+     * @brief Writes a fixed-size byte array into a buffer.
+     * @tparam Length length of the array
+     * @return new buffer with updated offset
+     */
+    template <std::size_t Length>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        Length <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + Length>
+        >::type put(const byte_array<Length> &bytes)
+    {
+        return put<Length>(bytes.data);
+    }
+
+    /**
+     * @brief Writes an array of values into a buffer.
+     * @tparam Count number of values to write
+     * @tparam T value type
+     * @return new buffer with updated offset
+     */
+    template <std::size_t Count, typename T>
+    typename details::enable_if<
+        Count * sizeof(T) <= (Size - Offset),
+        basic_static_buffer<byte_order, access_tag, Size, Offset + Count * sizeof(T)>
+        >::type put_array(const T *values)
+    {
+        details::assert_access<write_access_tag>(access_tag());
+        byte_order::encode_array(values, Count, pos());
+        return basic_static_buffer<byte_order, access_tag, Size, Offset + Count * sizeof(T)>(begin());
+    }
+
     /**
      * @brief Skips given bytes count from input sequence.
      * @tparam SkipBytes number of bytes to skip
      * @return new buffer with updated offset
      */
     template <std::size_t SkipBytes>
-    typename details::enable_if<
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
         (Offset + SkipBytes <= Size),
         basic_static_buffer<byte_order, access_tag, Size, Offset + SkipBytes>
         >::type skip() const
     {
-        return basic_static_buffer<byte_order, access_tag, Size, Offset + SkipBytes>(begin());
+        return basic_static_buffer<byte_order, access_tag, Size, Offset + SkipBytes>(begin_);
+    }
+
+    /**
+     * @brief Splits off the next `Length` bytes as a separate static
+     * buffer.
+     * @tparam Length length of the slice
+     * @return pair of buffer over the slice and buffer positioned
+     * after it
+     */
+    template <std::size_t Length>
+    ENCODING_BINARY_CONSTEXPR typename details::enable_if<
+        (Offset + Length <= Size),
+        std::pair<basic_static_buffer<byte_order, access_tag, Length, 0u>,
+                  basic_static_buffer<byte_order, access_tag, Size, Offset + Length> >
+        >::type slice() const
+    {
+        return std::pair<basic_static_buffer<byte_order, access_tag, Length, 0u>,
+                         basic_static_buffer<byte_order, access_tag, Size, Offset + Length> >(
+            basic_static_buffer<byte_order, access_tag, Length, 0u>(begin_ + Offset),
+            basic_static_buffer<byte_order, access_tag, Size, Offset + Length>(begin_));
     }
 
     /**
      * @brief Returns buffer with zero offset.
      * @return new buffer with zero offset
      */
-    buffer_beginning reset() const {
-        return buffer_beginning(begin());
+    ENCODING_BINARY_CONSTEXPR buffer_beginning reset() const {
+        return buffer_beginning(begin_);
     }
 
 private:
-    const iterator begin_;
+    template <typename T>
+    ENCODING_BINARY_CONSTEXPR T read(std::size_t at) const
+    {
+        details::assert_access<read_access_tag>(access_tag());
+        T value = T();
+        details::slack_decoder<T>::template decode<byte_order>(begin_ + at, Size - at, value);
+        return value;
+    }
+
+    iterator begin_;
 };
 
 /**
@@ -568,10 +1747,10 @@ public:
     typedef basic_static_buffer<default_byte_order, read_write_access_tag, Size, Offset> base;
     typedef typename base::iterator iterator;
 
-    static_buffer(base const &b): base(b)
+    ENCODING_BINARY_CONSTEXPR static_buffer(base const &b): base(b)
     {}
 
-    static_buffer(iterator begin): base(begin)
+    ENCODING_BINARY_CONSTEXPR static_buffer(iterator begin): base(begin)
     {}
 };
 
@@ -586,10 +1765,10 @@ public:
     typedef basic_static_buffer<default_byte_order, read_access_tag, Size, Offset> base;
     typedef typename base::iterator iterator;
 
-    readonly_static_buffer(base const &b): base(b)
+    ENCODING_BINARY_CONSTEXPR readonly_static_buffer(base const &b): base(b)
     {}
 
-    readonly_static_buffer(iterator begin): base(begin)
+    ENCODING_BINARY_CONSTEXPR readonly_static_buffer(iterator begin): base(begin)
     {}
 };
 
@@ -604,10 +1783,10 @@ public:
     typedef basic_static_buffer<default_byte_order, write_access_tag, Size, Offset> base;
     typedef typename base::iterator iterator;
 
-    writeonly_static_buffer(base const &b): base(b)
+    ENCODING_BINARY_CONSTEXPR writeonly_static_buffer(base const &b): base(b)
     {}
 
-    writeonly_static_buffer(iterator begin): base(begin)
+    ENCODING_BINARY_CONSTEXPR writeonly_static_buffer(iterator begin): base(begin)
     {}
 };
 
@@ -619,19 +1798,21 @@ public:
 template <
     typename ByteOrder,
     typename AccessTag,
+    typename OverflowPolicy,
     typename T>
-basic_buffer<ByteOrder, AccessTag> & operator>>(basic_buffer<ByteOrder, AccessTag> &buf,
-                                                T &value) {
+basic_buffer<ByteOrder, AccessTag, OverflowPolicy> &
+operator>>(basic_buffer<ByteOrder, AccessTag, OverflowPolicy> &buf, T &value) {
     return buf.get(value);
 }
 
 template <
     typename ByteOrder,
     typename AccessTag,
+    typename OverflowPolicy,
     typename T
     >
-basic_buffer<ByteOrder, AccessTag> & operator<<(basic_buffer<ByteOrder, AccessTag> &buf,
-                                                const T &value) {
+basic_buffer<ByteOrder, AccessTag, OverflowPolicy> &
+operator<<(basic_buffer<ByteOrder, AccessTag, OverflowPolicy> &buf, const T &value) {
     return buf.put(value);
 }
 
@@ -664,6 +1845,9 @@ struct is_readable
     static const bool value = access_tag::readable;
 };
 
+template <class BufferType>
+const bool is_readable<BufferType>::value;
+
 /**
  * @brief Compile-time function to check if it possible to write into a
  * buffer of specified type.
@@ -675,6 +1859,9 @@ struct is_writable
     static const bool value = access_tag::writable;
 };
 
+template <class BufferType>
+const bool is_writable<BufferType>::value;
+
 /** @} */
 
 } }
@@ -0,0 +1,279 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_BYTE_SWAP_H_
+#define ENCODING_BINARY_BYTE_SWAP_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include "encoding/binary/config.h"
+
+#if defined(_MSC_VER) && !ENCODING_BINARY_HAS_BUILTIN_BSWAP
+#  include <stdlib.h>
+#endif
+
+/**
+ * @file
+ * @brief Scalar byte swapping and unaligned memory access primitives
+ * used by encoding strategies.
+ */
+namespace encoding { namespace binary { namespace details {
+
+/**
+ * @defgroup ByteSwap byte swapping primitives.
+ * @{
+ */
+
+ENCODING_BINARY_CONSTEXPR inline uint8_t byte_swap(uint8_t val) { return val; }
+
+ENCODING_BINARY_CONSTEXPR inline uint16_t byte_swap(uint16_t val)
+{
+#if ENCODING_BINARY_HAS_BUILTIN_BSWAP
+    return __builtin_bswap16(val);
+#elif defined(_MSC_VER)
+    return _byteswap_ushort(val);
+#else
+    return uint16_t(val << 8 | val >> 8);
+#endif
+}
+
+ENCODING_BINARY_CONSTEXPR inline uint32_t byte_swap(uint32_t val)
+{
+#if ENCODING_BINARY_HAS_BUILTIN_BSWAP
+    return __builtin_bswap32(val);
+#elif defined(_MSC_VER)
+    return _byteswap_ulong(val);
+#else
+    return val << 24 | (val & 0xff00u) << 8 | (val >> 8 & 0xff00u) | val >> 24;
+#endif
+}
+
+ENCODING_BINARY_CONSTEXPR inline uint64_t byte_swap(uint64_t val)
+{
+#if ENCODING_BINARY_HAS_BUILTIN_BSWAP
+    return __builtin_bswap64(val);
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(val);
+#else
+    return uint64_t(byte_swap(uint32_t(val))) << 32 | byte_swap(uint32_t(val >> 32));
+#endif
+}
+
+/**
+ * @brief Converts a value between host and big-endian byte order.
+ * The conversion is an involution, so it works in both directions.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline T to_big(T val)
+{
+#if ENCODING_BINARY_HOST_BIG_ENDIAN
+    return val;
+#else
+    return byte_swap(val);
+#endif
+}
+
+/**
+ * @brief Converts a value between host and little-endian byte order.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline T to_little(T val)
+{
+#if ENCODING_BINARY_HOST_LITTLE_ENDIAN
+    return val;
+#else
+    return byte_swap(val);
+#endif
+}
+
+// 16-bit swaps are spelled as a rotate. It compiles to the same single
+// instruction, but unlike __builtin_bswap16 it doesn't keep GCC from
+// vectorizing loops of scalar puts.
+ENCODING_BINARY_CONSTEXPR inline uint16_t to_big(uint16_t val)
+{
+#if ENCODING_BINARY_HOST_BIG_ENDIAN
+    return val;
+#else
+    return uint16_t(val << 8 | val >> 8);
+#endif
+}
+
+ENCODING_BINARY_CONSTEXPR inline uint16_t to_little(uint16_t val)
+{
+#if ENCODING_BINARY_HOST_LITTLE_ENDIAN
+    return val;
+#else
+    return uint16_t(val << 8 | val >> 8);
+#endif
+}
+
+/** @} */
+
+/**
+ * @brief Unsigned integer type that carries the bits of `T` through
+ * byte order conversions. Only defined for arithmetic types the
+ * library knows how to encode.
+ */
+template <typename T> struct representation;
+
+template <> struct representation<uint8_t> { typedef uint8_t type; };
+template <> struct representation<uint16_t> { typedef uint16_t type; };
+template <> struct representation<uint32_t> { typedef uint32_t type; };
+template <> struct representation<uint64_t> { typedef uint64_t type; };
+template <> struct representation<int8_t> { typedef uint8_t type; };
+template <> struct representation<int16_t> { typedef uint16_t type; };
+template <> struct representation<int32_t> { typedef uint32_t type; };
+template <> struct representation<int64_t> { typedef uint64_t type; };
+template <> struct representation<float> { typedef uint32_t type; };
+template <> struct representation<double> { typedef uint64_t type; };
+
+/**
+ * @brief Reinterprets bits of a value as another type of the same
+ * size. Compiles to a register move (or nothing at all).
+ */
+template <typename To, typename From>
+inline To bit_cast(From from)
+{
+    To to;
+    std::memcpy(&to, &from, sizeof(to));
+    return to;
+}
+
+/**
+ * @brief Shift that brings the byte stored at offset `i` of an
+ * integer of type `T` in host memory to the least significant
+ * position.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline unsigned host_byte_shift(std::size_t i)
+{
+#if ENCODING_BINARY_HOST_LITTLE_ENDIAN
+    return unsigned(8 * i);
+#else
+    return unsigned(8 * (sizeof(T) - 1 - i));
+#endif
+}
+
+/**
+ * @brief Loads the first `length` bytes of the host representation
+ * of `T` from `buf`, leaving the remaining bytes zero.
+ *
+ * During constant evaluation `memcpy` is replaced with a byte loop
+ * producing the same value.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline T load_prefix(const uint8_t *buf, std::size_t length)
+{
+    T val = T();
+    if (ENCODING_BINARY_IS_CONSTANT_EVALUATED()) {
+        for (std::size_t i = 0; i < length; ++i) {
+            val = T(val | T(buf[i]) << host_byte_shift<T>(i));
+        }
+        return val;
+    }
+    std::memcpy(&val, buf, length);
+    return val;
+}
+
+/**
+ * @brief Stores the first `length` bytes of the host representation
+ * of `val` into `buf`.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline void store_prefix(T val, uint8_t *buf, std::size_t length)
+{
+    if (ENCODING_BINARY_IS_CONSTANT_EVALUATED()) {
+        for (std::size_t i = 0; i < length; ++i) {
+            buf[i] = uint8_t(val >> host_byte_shift<T>(i));
+        }
+        return;
+    }
+    std::memcpy(buf, &val, length);
+}
+
+/**
+ * @brief Loads a value from possibly unaligned memory. Compilers
+ * turn the `memcpy` into a single move instruction.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline T load(const uint8_t *buf)
+{
+    return load_prefix<T>(buf, sizeof(T));
+}
+
+/**
+ * @brief Stores a value into possibly unaligned memory.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline void store(T val, uint8_t *buf)
+{
+    store_prefix(val, buf, sizeof(T));
+}
+
+/**
+ * @brief Loads a value from memory aligned to `sizeof(T)`. The
+ * alignment promise lets compilers use aligned (vector) moves.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline T load_aligned(const uint8_t *buf)
+{
+    if (ENCODING_BINARY_IS_CONSTANT_EVALUATED()) return load<T>(buf);
+    T val = T();
+    std::memcpy(&val, ENCODING_BINARY_ASSUME_ALIGNED(buf, sizeof(T)), sizeof(val));
+    return val;
+}
+
+/**
+ * @brief Stores a value into memory aligned to `sizeof(T)`.
+ */
+template <typename T>
+ENCODING_BINARY_CONSTEXPR inline void store_aligned(T val, uint8_t *buf)
+{
+    if (ENCODING_BINARY_IS_CONSTANT_EVALUATED()) return store(val, buf);
+    std::memcpy(ENCODING_BINARY_ASSUME_ALIGNED(buf, sizeof(T)), &val, sizeof(val));
+}
+
+/**
+ * @brief Copies `length` bytes, usable in constant expressions.
+ */
+ENCODING_BINARY_CONSTEXPR inline void copy_bytes(uint8_t *dst, const uint8_t *src, std::size_t length)
+{
+    if (ENCODING_BINARY_IS_CONSTANT_EVALUATED()) {
+        for (std::size_t i = 0; i < length; ++i) dst[i] = src[i];
+        return;
+    }
+    std::memcpy(dst, src, length);
+}
+
+} } }
+
+#endif /* ENCODING_BINARY_BYTE_SWAP_H_ */
@@ -0,0 +1,465 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_CHAIN_BUFFER_H_
+#define ENCODING_BINARY_CHAIN_BUFFER_H_
+
+#include <utility>
+#include <vector>
+#include "encoding/binary/buffer.h"
+#include "encoding/binary/io_slice.h"
+
+/**
+ * @file
+ * @brief Writing buffer over a chain of fixed-size chunks.
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Pool of equally sized chunks. Released chunks are kept for
+ * reuse and freed when the pool is destroyed; all chunks must be
+ * released by then.
+ */
+class chunk_pool
+{
+public:
+    /**
+     * @brief Creates a pool of chunks of `chunk_size` bytes. Zero size
+     * throws `std::invalid_argument`, or aborts without exceptions.
+     */
+    explicit chunk_pool(std::size_t chunk_size = 4096)
+        : chunk_size_(chunk_size)
+    {
+        if (chunk_size == 0) {
+#if ENCODING_BINARY_HAS_EXCEPTIONS
+            throw std::invalid_argument("Chunk size must be positive");
+#else
+            std::abort();
+#endif
+        }
+    }
+
+    ~chunk_pool()
+    {
+        for (std::size_t i = 0; i < free_.size(); ++i) delete [] free_[i];
+    }
+
+    /**
+     * @brief Returns size of every chunk in bytes.
+     */
+    std::size_t chunk_size() const { return chunk_size_; }
+
+    /**
+     * @brief Returns a chunk, reusing a released one if possible.
+     */
+    uint8_t * acquire()
+    {
+        if (free_.empty()) return new uint8_t[chunk_size_];
+        uint8_t *chunk = free_.back();
+        free_.pop_back();
+        return chunk;
+    }
+
+    /**
+     * @brief Gives a chunk back to the pool.
+     */
+    void release(uint8_t *chunk)
+    {
+        free_.push_back(chunk);
+    }
+
+private:
+    chunk_pool(const chunk_pool &);
+    chunk_pool & operator=(const chunk_pool &);
+
+    std::size_t chunk_size_;
+    std::vector<uint8_t*> free_;
+};
+
+/**
+ * @brief Writing buffer that puts bytes into a chain of chunks taken
+ * from a `chunk_pool`, so output of any size is written once without
+ * reallocation or re-copying.
+ *
+ * Values that fit into the current chunk are encoded in place, exactly
+ * like in `basic_buffer`. Values straddling a chunk boundary are
+ * encoded aside and split. Written bytes are exposed as an array of
+ * `io_slice`, one per chunk.
+ *
+ * @tparam ByteOrder byte order used for encoding
+ */
+template <typename ByteOrder = default_byte_order>
+class basic_chain_buffer
+{
+public:
+    typedef ByteOrder byte_order;
+    typedef write_access_tag access_tag;
+    typedef access_traits<access_tag>::value_type value_type;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+
+    explicit basic_chain_buffer(chunk_pool &pool)
+        : pool_(&pool)
+        , pos_(0)
+        , end_(0)
+        , full_size_(0)
+    {}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+    /**
+     * @brief Takes over chunks of another buffer, which becomes empty
+     * but stays bound to its pool.
+     */
+    basic_chain_buffer(basic_chain_buffer &&other)
+        : pool_(other.pool_)
+        , chunks_(std::move(other.chunks_))
+        , pos_(other.pos_)
+        , end_(other.end_)
+        , full_size_(other.full_size_)
+    {
+        other.forget_chunks();
+    }
+
+    basic_chain_buffer & operator=(basic_chain_buffer &&other)
+    {
+        if (this != &other) {
+            release_chunks();
+            pool_ = other.pool_;
+            chunks_ = std::move(other.chunks_);
+            pos_ = other.pos_;
+            end_ = other.end_;
+            full_size_ = other.full_size_;
+            other.forget_chunks();
+        }
+        return *this;
+    }
+#endif
+
+    ~basic_chain_buffer()
+    {
+        release_chunks();
+    }
+
+    /**
+     * @brief Returns number of bytes written.
+     */
+    std::size_t size() const
+    {
+        return chunks_.empty() ? 0 : full_size_ + std::size_t(pos_ - current());
+    }
+
+    /**
+     * @brief Returns number of chunks in use.
+     */
+    std::size_t chunk_count() const { return chunks_.size(); }
+
+    /**
+     * @brief Returns slices describing the written bytes, in order.
+     * The pointer stays valid until the next modification.
+     */
+    const io_slice * slices()
+    {
+        if (!chunks_.empty()) chunks_.back().iov_len = std::size_t(pos_ - current());
+        return chunks_.empty() ? 0 : &chunks_[0];
+    }
+
+    /**
+     * @brief Gives all chunks back to the pool.
+     * @return current buffer
+     */
+    basic_chain_buffer & clear()
+    {
+        release_chunks();
+        forget_chunks();
+        return *this;
+    }
+
+    /**
+     * @brief Puts a value into a buffer.
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Puts a value into a buffer using given byte order instead
+     * of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_chain_buffer &>::type
+    put(T value)
+    {
+        // The position is copied, so that it needn't be reloaded after
+        // the byte store, which may alias any member.
+        const iterator pos = pos_;
+        if (ENCODING_BINARY_UNLIKELY(std::size_t(end_ - pos) < wire_size<T>::value)) {
+            return put_split<Order>(value);
+        }
+        Order::encode(value, pos);
+        pos_ = pos + wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Copies sequence of bytes into a buffer, spreading it over
+     * as many chunks as needed.
+     * @param from input sequence begin
+     * @param length length of the input sequence
+     * @return current buffer
+     */
+    basic_chain_buffer & put(const value_type *from, std::size_t length)
+    {
+        while (length) {
+            if (pos_ == end_) next_chunk();
+            const std::size_t room = std::size_t(end_ - pos_);
+            const std::size_t n = length < room ? length : room;
+            std::memcpy(pos_, from, n);
+            pos_ += n;
+            from += n;
+            length -= n;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Copies a fixed-size byte array into a buffer.
+     * @return current buffer
+     */
+    template <std::size_t Length>
+    basic_chain_buffer & put(const byte_array<Length> &bytes)
+    {
+        return put(bytes.data, Length);
+    }
+
+    /**
+     * @brief Puts an array of values into a buffer. Values that fit
+     * into the current chunk are converted in bulk.
+     * @tparam T value type
+     * @param values pointer to the first value
+     * @param count number of values to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & put_array(const T *values, std::size_t count)
+    {
+        while (count) {
+            std::size_t n = std::size_t(end_ - pos_) / sizeof(T);
+            if (n == 0) {
+                put(*values++);
+                --count;
+                continue;
+            }
+            if (n > count) n = count;
+            byte_order::encode_array(values, n, pos_);
+            pos_ += n * sizeof(T);
+            values += n;
+            count -= n;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Puts an unsigned LEB128 varint into a buffer.
+     * @tparam T value type, `uint32_t` or `uint64_t`
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & put_varint(T value)
+    {
+        if (ENCODING_BINARY_UNLIKELY(std::size_t(end_ - pos_) < details::varint_traits<T>::max_size)) {
+            uint8_t bytes[details::varint_traits<T>::max_size];
+            return put(bytes, details::encode_varint(value, bytes));
+        }
+        pos_ += details::encode_varint(value, pos_);
+        return *this;
+    }
+
+    /**
+     * @brief Puts a signed value as a ZigZag-encoded varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & put_svarint(T value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        return put_varint(details::zigzag_encode(bits(value)));
+    }
+
+    /**
+     * @brief Reserves a zeroed field to be filled in later, e.g. with a
+     * length or a checksum of what follows.
+     * @tparam T field type
+     * @return handle of the field
+     */
+    template <typename T>
+    placeholder<T> put_placeholder()
+    {
+        placeholder<T> field = { size() };
+        put(T());
+        return field;
+    }
+
+    /**
+     * @brief Writes a value into a reserved field, which may straddle
+     * chunks. Position doesn't change.
+     * @tparam T field type
+     * @param field handle returned by `put_placeholder`
+     * @param value value to write
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & fill(placeholder<T> field, T value)
+    {
+        if (!details::placeholder_fits(field, size())) throw_on_overflow::on_overflow();
+        uint8_t bytes[wire_size<T>::value];
+        byte_order::encode(value, bytes);
+        // All chunks but the last one are full, so the field is found
+        // by division.
+        const std::size_t chunk_size = pool_->chunk_size();
+        std::size_t chunk = field.offset / chunk_size;
+        std::size_t offset = field.offset % chunk_size;
+        const uint8_t *from = bytes;
+        std::size_t length = wire_size<T>::value;
+        while (length) {
+            const std::size_t n = length < chunk_size - offset ? length : chunk_size - offset;
+            std::memcpy(static_cast<uint8_t*>(chunks_[chunk].iov_base) + offset, from, n);
+            from += n;
+            length -= n;
+            ++chunk;
+            offset = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Writes number of bytes put after a reserved field into
+     * the field. A length that doesn't fit `T` is an overflow.
+     * @tparam T field type, an unsigned integer or `packed_uint`
+     * @param field handle returned by `put_placeholder`
+     * @return current buffer
+     */
+    template <typename T>
+    basic_chain_buffer & fill_length(placeholder<T> field)
+    {
+        if (!details::placeholder_fits(field, size())
+            || !details::blob_prefix<T>::fits(details::placeholder_length(field, size()))) {
+            throw_on_overflow::on_overflow();
+        }
+        return fill(field, T(details::placeholder_length(field, size())));
+    }
+
+private:
+    basic_chain_buffer(const basic_chain_buffer &);
+    basic_chain_buffer & operator=(const basic_chain_buffer &);
+
+    // Cold, so that the call is moved out of the caller's loop and a
+    // put that fits falls straight through.
+    template <typename Order, typename T>
+    ENCODING_BINARY_COLD basic_chain_buffer & put_split(T value)
+    {
+        uint8_t bytes[wire_size<T>::value];
+        Order::encode(value, bytes);
+        return put(bytes, wire_size<T>::value);
+    }
+
+    uint8_t * current() const
+    {
+        return static_cast<uint8_t*>(chunks_.back().iov_base);
+    }
+
+    ENCODING_BINARY_NOINLINE void next_chunk()
+    {
+        if (!chunks_.empty()) {
+            chunks_.back().iov_len = std::size_t(pos_ - current());
+            full_size_ += chunks_.back().iov_len;
+        }
+        io_slice slice;
+        slice.iov_base = pool_->acquire();
+        slice.iov_len = 0;
+        chunks_.push_back(slice);
+        pos_ = current();
+        end_ = pos_ + pool_->chunk_size();
+    }
+
+    void forget_chunks()
+    {
+        chunks_.clear();
+        pos_ = end_ = 0;
+        full_size_ = 0;
+    }
+
+    void release_chunks()
+    {
+        // Backwards, so the pool hands chunks out in the same order
+        // next time and writes keep going up through memory.
+        for (std::size_t i = chunks_.size(); i != 0; --i) {
+            pool_->release(static_cast<uint8_t*>(chunks_[i - 1].iov_base));
+        }
+    }
+
+    chunk_pool *pool_;
+    std::vector<io_slice> chunks_;
+    iterator pos_;
+    iterator end_;
+    std::size_t full_size_;   // bytes in all chunks but the last one
+};
+
+/**
+ * @brief Chained buffer with network byte order.
+ */
+typedef basic_chain_buffer<> chain_buffer;
+
+/**
+ * @brief Chained buffer with little-endian byte order.
+ */
+typedef basic_chain_buffer<little_endian> le_chain_buffer;
+
+template <typename ByteOrder, typename T>
+basic_chain_buffer<ByteOrder> & operator<<(basic_chain_buffer<ByteOrder> &buf, const T &value) {
+    return buf.put(value);
+}
+
+} }
+
+#endif /* ENCODING_BINARY_CHAIN_BUFFER_H_ */
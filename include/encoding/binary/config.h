@@ -0,0 +1,211 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_CONFIG_H_
+#define ENCODING_BINARY_CONFIG_H_
+
+/**
+ * @file
+ * @brief Compiler and platform detection.
+ *
+ * Host byte order is detected at compile time. If detection fails on
+ * an exotic platform, define either `ENCODING_BINARY_HOST_LITTLE_ENDIAN`
+ * or `ENCODING_BINARY_HOST_BIG_ENDIAN` to 1 before including any
+ * library header.
+ */
+
+/*
+ * A user-defined byte order macro must expand to 1 or 0: it's used in
+ * `#if` and as a template argument. `~(~X + 1) == 1` holds only when
+ * `X` is defined empty.
+ */
+#if defined(ENCODING_BINARY_HOST_LITTLE_ENDIAN) \
+    && ~(~ENCODING_BINARY_HOST_LITTLE_ENDIAN + 0) == 0 && ~(~ENCODING_BINARY_HOST_LITTLE_ENDIAN + 1) == 1
+#  error "ENCODING_BINARY_HOST_LITTLE_ENDIAN is defined empty, define it to 1 or 0"
+#endif
+#if defined(ENCODING_BINARY_HOST_BIG_ENDIAN) \
+    && ~(~ENCODING_BINARY_HOST_BIG_ENDIAN + 0) == 0 && ~(~ENCODING_BINARY_HOST_BIG_ENDIAN + 1) == 1
+#  error "ENCODING_BINARY_HOST_BIG_ENDIAN is defined empty, define it to 1 or 0"
+#endif
+
+#if defined(ENCODING_BINARY_HOST_LITTLE_ENDIAN) && defined(ENCODING_BINARY_HOST_BIG_ENDIAN)
+#  if !ENCODING_BINARY_HOST_LITTLE_ENDIAN == !ENCODING_BINARY_HOST_BIG_ENDIAN
+#    error "ENCODING_BINARY_HOST_LITTLE_ENDIAN and ENCODING_BINARY_HOST_BIG_ENDIAN contradict each other"
+#  endif
+#elif defined(ENCODING_BINARY_HOST_LITTLE_ENDIAN)
+#  if ENCODING_BINARY_HOST_LITTLE_ENDIAN
+#    define ENCODING_BINARY_HOST_BIG_ENDIAN 0
+#  else
+#    define ENCODING_BINARY_HOST_BIG_ENDIAN 1
+#  endif
+#elif defined(ENCODING_BINARY_HOST_BIG_ENDIAN)
+#  if ENCODING_BINARY_HOST_BIG_ENDIAN
+#    define ENCODING_BINARY_HOST_LITTLE_ENDIAN 0
+#  else
+#    define ENCODING_BINARY_HOST_LITTLE_ENDIAN 1
+#  endif
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define ENCODING_BINARY_HOST_LITTLE_ENDIAN 1
+#  define ENCODING_BINARY_HOST_BIG_ENDIAN 0
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define ENCODING_BINARY_HOST_LITTLE_ENDIAN 0
+#  define ENCODING_BINARY_HOST_BIG_ENDIAN 1
+#elif defined(_WIN32) || defined(__i386__) || defined(__x86_64__) \
+    || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64)
+#  define ENCODING_BINARY_HOST_LITTLE_ENDIAN 1
+#  define ENCODING_BINARY_HOST_BIG_ENDIAN 0
+#else
+#  error "Unable to detect host byte order, define ENCODING_BINARY_HOST_LITTLE_ENDIAN"
+#endif
+
+#if defined(__clang__) \
+    || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8)))
+#  define ENCODING_BINARY_HAS_BUILTIN_BSWAP 1
+#else
+#  define ENCODING_BINARY_HAS_BUILTIN_BSWAP 0
+#endif
+
+/*
+ * Encoding is usable in constant expressions when the compiler
+ * supports C++14 constexpr and can tell constant evaluation apart,
+ * so that `memcpy`-based loads and stores have a byte-wise
+ * counterpart during compilation.
+ */
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_is_constant_evaluated)
+#    define ENCODING_BINARY_HAS_IS_CONSTANT_EVALUATED 1
+#  endif
+#endif
+#if !defined(ENCODING_BINARY_HAS_IS_CONSTANT_EVALUATED) && !defined(__clang__) \
+    && defined(__GNUC__) && __GNUC__ >= 9
+#  define ENCODING_BINARY_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+
+#if __cplusplus >= 201402L && defined(ENCODING_BINARY_HAS_IS_CONSTANT_EVALUATED) \
+    && ENCODING_BINARY_HAS_BUILTIN_BSWAP
+#  define ENCODING_BINARY_HAS_CONSTEXPR_ENCODING 1
+#  define ENCODING_BINARY_CONSTEXPR constexpr
+#  define ENCODING_BINARY_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#  define ENCODING_BINARY_HAS_CONSTEXPR_ENCODING 0
+#  define ENCODING_BINARY_CONSTEXPR
+#  define ENCODING_BINARY_IS_CONSTANT_EVALUATED() false
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define ENCODING_BINARY_ASSUME_ALIGNED(ptr, alignment) \
+    __builtin_assume_aligned((ptr), (alignment))
+#else
+#  define ENCODING_BINARY_ASSUME_ALIGNED(ptr, alignment) (ptr)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define ENCODING_BINARY_NOINLINE __attribute__((noinline))
+#  define ENCODING_BINARY_COLD __attribute__((noinline, cold))
+#  define ENCODING_BINARY_UNLIKELY(cond) __builtin_expect(!!(cond), 0)
+#elif defined(_MSC_VER)
+#  define ENCODING_BINARY_NOINLINE __declspec(noinline)
+#  define ENCODING_BINARY_COLD __declspec(noinline)
+#  define ENCODING_BINARY_UNLIKELY(cond) (cond)
+#else
+#  define ENCODING_BINARY_NOINLINE
+#  define ENCODING_BINARY_COLD
+#  define ENCODING_BINARY_UNLIKELY(cond) (cond)
+#endif
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#  define ENCODING_BINARY_HAS_RVALUE_REFERENCES 1
+#else
+#  define ENCODING_BINARY_HAS_RVALUE_REFERENCES 0
+#endif
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#  define ENCODING_BINARY_HAS_EXCEPTIONS 1
+#else
+#  define ENCODING_BINARY_HAS_EXCEPTIONS 0
+#endif
+
+/*
+ * Byte sequences of at least this many bytes are copied into buffers
+ * with non-temporal stores, so huge payloads don't evict the working
+ * set from cache. Define to 0 to always use `memcpy`.
+ */
+#ifndef ENCODING_BINARY_STREAMING_THRESHOLD
+#  define ENCODING_BINARY_STREAMING_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#  define ENCODING_BINARY_X86 1
+#else
+#  define ENCODING_BINARY_X86 0
+#endif
+
+/*
+ * Runtime dispatch compiles every kernel for every instruction set
+ * level using per-function target attributes and picks the best one
+ * supported by the CPU on first use. Define
+ * `ENCODING_BINARY_NO_RUNTIME_DISPATCH` to fall back to compile-time
+ * selection driven by `-m` flags.
+ */
+#if ENCODING_BINARY_X86 && !defined(ENCODING_BINARY_NO_RUNTIME_DISPATCH) \
+    && (defined(__clang__) \
+        || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  define ENCODING_BINARY_RUNTIME_DISPATCH 1
+#  define ENCODING_BINARY_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define ENCODING_BINARY_RUNTIME_DISPATCH 0
+#  define ENCODING_BINARY_TARGET(isa)
+#endif
+
+#if ENCODING_BINARY_RUNTIME_DISPATCH || defined(__SSE2__) || defined(_M_X64)
+#  define ENCODING_BINARY_HAS_SSE2 1
+#else
+#  define ENCODING_BINARY_HAS_SSE2 0
+#endif
+#if ENCODING_BINARY_RUNTIME_DISPATCH || defined(__SSSE3__)
+#  define ENCODING_BINARY_HAS_SSSE3 1
+#else
+#  define ENCODING_BINARY_HAS_SSSE3 0
+#endif
+#if ENCODING_BINARY_RUNTIME_DISPATCH || defined(__AVX2__)
+#  define ENCODING_BINARY_HAS_AVX2 1
+#else
+#  define ENCODING_BINARY_HAS_AVX2 0
+#endif
+#if ENCODING_BINARY_RUNTIME_DISPATCH || defined(__AVX512BW__)
+#  define ENCODING_BINARY_HAS_AVX512 1
+#else
+#  define ENCODING_BINARY_HAS_AVX512 0
+#endif
+
+#endif /* ENCODING_BINARY_CONFIG_H_ */
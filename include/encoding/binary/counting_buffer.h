@@ -0,0 +1,255 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_COUNTING_BUFFER_H_
+#define ENCODING_BINARY_COUNTING_BUFFER_H_
+
+#include "encoding/binary/buffer.h"
+
+/**
+ * @file
+ * @brief Buffer that counts bytes instead of writing them.
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Writing buffer that only counts bytes put into it. It accepts
+ * the same `put` overloads as `basic_buffer`, so an encoder written as
+ * a template over the buffer type computes the exact size of its
+ * output in a dry run, e.g. to allocate once before the real write.
+ *
+ * Fixed-size values add constants; varints and blobs add their encoded
+ * sizes. Nothing is ever written, so a counting buffer never overflows.
+ * Values go through the codecs of the real buffer in unevaluated
+ * context, so a type `basic_buffer` can't encode fails to compile
+ * here too.
+ * Encoders that write through `pos()`, like `put_stream_vbyte`, should
+ * count with the matching size function (`stream_vbyte_size`) instead.
+ *
+ * @tparam ByteOrder byte order of the real buffer, unused
+ */
+template <typename ByteOrder = default_byte_order>
+class basic_counting_buffer
+{
+public:
+    typedef ByteOrder byte_order;
+    typedef write_access_tag access_tag;
+    typedef access_traits<access_tag>::value_type value_type;
+
+    basic_counting_buffer() : size_(0) {}
+
+    /**
+     * @brief Returns number of bytes counted so far.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Starts counting from zero.
+     * @return current buffer
+     */
+    basic_counting_buffer & clear()
+    {
+        size_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief Counts a value.
+     * @tparam T value type
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Counts a value put with given byte order.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @return current buffer
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_counting_buffer &>::type
+    put(T value)
+    {
+        (void) sizeof((Order::encode(value, static_cast<uint8_t*>(0)), 0));
+        size_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Counts a sequence of bytes.
+     * @param length length of the input sequence
+     * @return current buffer
+     */
+    basic_counting_buffer & put(const value_type *, std::size_t length)
+    {
+        size_ += length;
+        return *this;
+    }
+
+    /**
+     * @brief Counts a fixed-size byte array.
+     * @return current buffer
+     */
+    template <std::size_t Length>
+    basic_counting_buffer & put(const byte_array<Length> &)
+    {
+        size_ += Length;
+        return *this;
+    }
+
+    /**
+     * @brief Counts an array of values.
+     * @tparam T value type
+     * @param count number of values
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & put_array(const T *, std::size_t count)
+    {
+        // Taking the address instantiates the kernel, which is where
+        // unsupported types are rejected.
+        void (*encode)(const T *, std::size_t, uint8_t *) = &byte_order::encode_array;
+        (void) encode;
+        size_ += count * sizeof(T);
+        return *this;
+    }
+
+    /**
+     * @brief Counts an unsigned LEB128 varint.
+     * @tparam T value type, `uint32_t` or `uint64_t`
+     * @param value value to count
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & put_varint(T value)
+    {
+        (void) sizeof(details::static_check<details::varint_traits<T>::max_size != 0>);
+        size_ += details::varint_size(value);
+        return *this;
+    }
+
+    /**
+     * @brief Counts a ZigZag-encoded signed varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value value to count
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & put_svarint(T value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        return put_varint(details::zigzag_encode(bits(value)));
+    }
+
+    /**
+     * @brief Counts a byte sequence preceded by its length.
+     * @tparam Prefix length type used by `put_blob`
+     * @param length length of the input sequence
+     * @return current buffer
+     */
+    template <typename Prefix>
+    basic_counting_buffer & put_blob(const value_type *, std::size_t length)
+    {
+        size_ += details::blob_prefix<Prefix>::size(length) + length;
+        return *this;
+    }
+
+    /**
+     * @brief Counts a field reserved for later.
+     * @tparam T field type
+     * @return handle of the field
+     */
+    template <typename T>
+    placeholder<T> put_placeholder()
+    {
+        placeholder<T> field = { size_ };
+        put(T());
+        return field;
+    }
+
+    /**
+     * @brief Does nothing, as filling a field doesn't change the size.
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & fill(placeholder<T>, T value)
+    {
+        (void) sizeof((byte_order::encode(value, static_cast<uint8_t*>(0)), 0));
+        return *this;
+    }
+
+    /**
+     * @brief Does nothing, as filling a field doesn't change the size.
+     * @return current buffer
+     */
+    template <typename T>
+    basic_counting_buffer & fill_length(placeholder<T>)
+    {
+        return *this;
+    }
+
+    /**
+     * @brief Counts `count` bytes left as they are.
+     * @return current buffer
+     */
+    basic_counting_buffer & skip(std::size_t count)
+    {
+        size_ += count;
+        return *this;
+    }
+
+private:
+    std::size_t size_;
+};
+
+/**
+ * @brief Counting buffer for encoders using network byte order.
+ */
+typedef basic_counting_buffer<> counting_buffer;
+
+/**
+ * @brief Counting buffer for encoders using little-endian byte order.
+ */
+typedef basic_counting_buffer<little_endian> le_counting_buffer;
+
+template <typename ByteOrder, typename T>
+basic_counting_buffer<ByteOrder> & operator<<(basic_counting_buffer<ByteOrder> &buf, const T &value) {
+    return buf.put(value);
+}
+
+} }
+
+#endif /* ENCODING_BINARY_COUNTING_BUFFER_H_ */
@@ -0,0 +1,180 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_CPU_H_
+#define ENCODING_BINARY_CPU_H_
+
+#include "encoding/binary/config.h"
+
+/**
+ * @file
+ * @brief CPU feature detection used to dispatch bulk kernels.
+ *
+ * The best instruction set level is resolved once, on first use of
+ * any kernel. Benchmarks and tests may lower it with
+ * `force_cpu_level` to compare implementations on one machine.
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Instruction set levels bulk kernels are specialized for,
+ * from the most portable to the fastest.
+ */
+enum cpu_level {
+    cpu_level_scalar,
+    cpu_level_sse2,
+    cpu_level_ssse3,
+    cpu_level_avx2,
+    cpu_level_avx512
+};
+
+namespace details {
+
+/**
+ * @brief Returns the best level both compiled in and supported by
+ * the running CPU.
+ */
+inline cpu_level probe_cpu_level()
+{
+#if ENCODING_BINARY_RUNTIME_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) return cpu_level_avx512;
+    if (__builtin_cpu_supports("avx2")) return cpu_level_avx2;
+    if (__builtin_cpu_supports("ssse3")) return cpu_level_ssse3;
+    if (__builtin_cpu_supports("sse2")) return cpu_level_sse2;
+    return cpu_level_scalar;
+#elif ENCODING_BINARY_HAS_AVX512
+    return cpu_level_avx512;
+#elif ENCODING_BINARY_HAS_AVX2
+    return cpu_level_avx2;
+#elif ENCODING_BINARY_HAS_SSSE3
+    return cpu_level_ssse3;
+#elif ENCODING_BINARY_HAS_SSE2
+    return cpu_level_sse2;
+#else
+    return cpu_level_scalar;
+#endif
+}
+
+/**
+ * @brief Process-wide dispatch state. Negative values mean "not
+ * resolved yet". Being a class template member it can live in a
+ * header without violating the one-definition rule.
+ */
+template <typename Dummy = void>
+struct cpu_dispatch {
+    static int detected;
+    static int active;
+
+    static int load(const int &level) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __atomic_load_n(&level, __ATOMIC_RELAXED);
+#else
+        return *static_cast<const volatile int*>(&level);
+#endif
+    }
+
+    static void store(int &level, int value) {
+#if defined(__GNUC__) || defined(__clang__)
+        __atomic_store_n(&level, value, __ATOMIC_RELAXED);
+#else
+        *static_cast<volatile int*>(&level) = value;
+#endif
+    }
+};
+
+template <typename Dummy> int cpu_dispatch<Dummy>::detected = -1;
+template <typename Dummy> int cpu_dispatch<Dummy>::active = -1;
+
+}
+
+/**
+ * @brief Returns the best instruction set level available on the
+ * running CPU.
+ */
+inline cpu_level detected_cpu_level()
+{
+    typedef details::cpu_dispatch<> state;
+    int level = state::load(state::detected);
+    if (level < 0) {
+        level = details::probe_cpu_level();
+        state::store(state::detected, level);
+    }
+    return cpu_level(level);
+}
+
+/**
+ * @brief Returns the instruction set level bulk kernels currently
+ * use.
+ */
+inline cpu_level active_cpu_level()
+{
+    typedef details::cpu_dispatch<> state;
+    int level = state::load(state::active);
+    if (level < 0) {
+        level = detected_cpu_level();
+        state::store(state::active, level);
+    }
+    return cpu_level(level);
+}
+
+/**
+ * @brief Forces bulk kernels to use the given level. Levels above
+ * the detected one are clamped to it.
+ * @return level actually in use
+ */
+inline cpu_level force_cpu_level(cpu_level level)
+{
+    typedef details::cpu_dispatch<> state;
+    const cpu_level detected = detected_cpu_level();
+    if (level > detected) level = detected;
+    state::store(state::active, level);
+    return level;
+}
+
+/**
+ * @brief Returns a human-readable name of an instruction set level.
+ */
+inline const char * cpu_level_name(cpu_level level)
+{
+    switch (level) {
+    case cpu_level_scalar: return "scalar";
+    case cpu_level_sse2: return "sse2";
+    case cpu_level_ssse3: return "ssse3";
+    case cpu_level_avx2: return "avx2";
+    case cpu_level_avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+} }
+
+#endif /* ENCODING_BINARY_CPU_H_ */
@@ -0,0 +1,113 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_DELTA_H_
+#define ENCODING_BINARY_DELTA_H_
+
+#include "encoding/binary/buffer.h"
+
+/**
+ * @file
+ * @brief Delta streams of integer arrays.
+ *
+ * Each value is stored as the difference from the previous one (the
+ * first one from zero) in a ZigZag varint, so sorted and nearly
+ * sorted arrays take a byte or two per value and occasional steps
+ * back stay cheap. Differences wrap around, so any array round-trips.
+ *
+ * Varints have no byte order: the functions work with buffers of
+ * every byte order and overflow policy.
+ */
+namespace encoding { namespace binary {
+
+namespace details {
+
+/**
+ * @brief Unsigned type deltas of `T` are computed in. Defined for
+ * 32- and 64-bit integers.
+ */
+template <typename T> struct delta_traits;
+
+template <> struct delta_traits<uint32_t> { typedef uint32_t type; };
+template <> struct delta_traits<int32_t> { typedef uint32_t type; };
+template <> struct delta_traits<uint64_t> { typedef uint64_t type; };
+template <> struct delta_traits<int64_t> { typedef uint64_t type; };
+
+}
+
+/**
+ * @brief Puts `count` values as a delta stream.
+ * @tparam BufferType writing buffer type
+ * @tparam T 32- or 64-bit integer type
+ * @return `buf`
+ */
+template <typename BufferType, typename T>
+BufferType & put_deltas(BufferType &buf, const T *values, std::size_t count)
+{
+    typedef typename details::delta_traits<T>::type bits;
+    bits prev = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const bits cur = bits(values[i]);
+        buf.put_varint(details::zigzag_encode(bits(cur - prev)));
+        prev = cur;
+    }
+    return buf;
+}
+
+/**
+ * @brief Reads `count` values of a delta stream. Deltas are decoded
+ * first and then summed up with a vectorized prefix sum. When the
+ * buffer's policy lets decoding go on after a failure, values from the
+ * failed one on are left untouched.
+ * @tparam BufferType reading buffer type
+ * @tparam T 32- or 64-bit integer type
+ * @return `buf`
+ */
+template <typename BufferType, typename T>
+BufferType & get_deltas(BufferType &buf, T *values, std::size_t count)
+{
+    typedef typename details::delta_traits<T>::type bits;
+    // Signed and unsigned variants of a type may alias each other.
+    bits *deltas = reinterpret_cast<bits*>(values);
+    std::size_t decoded = 0;
+    for (; decoded < count; ++decoded) {
+        bits zigzag = 0;
+        buf.get_varint(zigzag);
+        if (ENCODING_BINARY_UNLIKELY(buf.overflowed())) break;
+        deltas[decoded] = details::zigzag_decode(zigzag);
+    }
+    details::prefix_sum(deltas, decoded, bits(0));
+    return buf;
+}
+
+} }
+
+#endif /* ENCODING_BINARY_DELTA_H_ */
@@ -0,0 +1,482 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_DYNAMIC_BUFFER_H_
+#define ENCODING_BINARY_DYNAMIC_BUFFER_H_
+
+#include <memory>
+#include <utility>
+#include "encoding/binary/buffer.h"
+
+/**
+ * @file
+ * @brief Implementation of growable writing buffers.
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Storage handed off by `basic_dynamic_buffer::release`. It
+ * must be freed with the allocator of the buffer:
+ * `alloc.deallocate(data, capacity)`, unless `data` is null, which is
+ * the case when nothing was written.
+ */
+struct dynamic_storage {
+    uint8_t *data;
+    std::size_t size;
+    std::size_t capacity;
+};
+
+/**
+ * @brief Writing buffer that grows on demand.
+ *
+ * Bytes are first written to an inline region of `InlineSize` bytes,
+ * so small messages never touch the heap. `InlineSize` may be 0 to
+ * go to the heap on the first write. Once it's full, the buffer
+ * moves to storage obtained from `Allocator`, doubling the capacity
+ * on every growth.
+ *
+ *     begin          pos               end
+ *       V             V                 V
+ *       |-------------|-----------------|
+ *        written bytes  spare capacity
+ *
+ * The buffer supports the same `put` operations as `basic_buffer`,
+ * except that they never overflow. Written bytes are available with
+ * `data()` and `size()` for I/O without copying.
+ *
+ * @tparam ByteOrder byte order used for encoding
+ * @tparam InlineSize size of the inline region in bytes
+ * @tparam Allocator allocator of `uint8_t`
+ */
+template <
+    typename ByteOrder = default_byte_order,
+    std::size_t InlineSize = 256,
+    typename Allocator = std::allocator<uint8_t>
+    >
+class basic_dynamic_buffer : private Allocator
+{
+public:
+    typedef ByteOrder byte_order;
+    typedef write_access_tag access_tag;
+    typedef Allocator allocator_type;
+    typedef access_traits<access_tag>::value_type value_type;
+    typedef access_traits<access_tag>::iterator iterator;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+
+    explicit basic_dynamic_buffer(const Allocator &alloc = Allocator())
+        : Allocator(alloc)
+        , begin_(inline_)
+        , end_(inline_ + InlineSize)
+        , pos_(inline_)
+    {}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+    /**
+     * @brief Takes over written bytes of another buffer, which becomes
+     * empty. Bytes in the inline region are copied.
+     */
+    basic_dynamic_buffer(basic_dynamic_buffer &&other)
+        : Allocator(std::move(static_cast<Allocator &>(other)))
+    {
+        take(other);
+    }
+
+    basic_dynamic_buffer & operator=(basic_dynamic_buffer &&other)
+    {
+        if (this != &other) {
+            deallocate();
+            static_cast<Allocator &>(*this) = std::move(static_cast<Allocator &>(other));
+            take(other);
+        }
+        return *this;
+    }
+#endif
+
+    ~basic_dynamic_buffer()
+    {
+        deallocate();
+    }
+
+    /**
+     * @brief Returns allocator of a buffer.
+     */
+    allocator_type get_allocator() const { return *this; }
+
+    /**
+     * @brief Returns pointer to the written bytes.
+     */
+    const_iterator data() const { return begin_; }
+    iterator data() { return begin_; }
+
+    /**
+     * @brief Returns number of bytes written.
+     */
+    std::size_t size() const { return pos_ - begin_; }
+
+    /**
+     * @brief Returns number of bytes that fit without growing.
+     */
+    std::size_t capacity() const { return end_ - begin_; }
+
+    /**
+     * @brief Returns the largest capacity the allocator can provide.
+     * Growing past it throws `std::length_error`.
+     */
+    std::size_t max_size() const
+    {
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+        return std::allocator_traits<Allocator>::max_size(*this);
+#else
+        return Allocator::max_size();
+#endif
+    }
+
+    /**
+     * @brief Returns position of a buffer.
+     */
+    const_iterator pos() const { return pos_; }
+
+    /**
+     * @brief Tells whether bytes are still in the inline region.
+     */
+    bool is_inline() const { return begin_ == inline_; }
+
+    /**
+     * @brief Returns read-only buffer over the written bytes.
+     */
+    basic_buffer<byte_order, read_access_tag> written() const
+    {
+        return basic_buffer<byte_order, read_access_tag>(data(), size());
+    }
+
+    /**
+     * @brief Discards written bytes keeping the capacity.
+     * @return current buffer
+     */
+    basic_dynamic_buffer & clear()
+    {
+        pos_ = begin_;
+        return *this;
+    }
+
+    /**
+     * @brief Makes sure that `length` more bytes fit without growing.
+     * @return current buffer
+     */
+    basic_dynamic_buffer & ensure(std::size_t length)
+    {
+        if (ENCODING_BINARY_UNLIKELY(std::size_t(end_ - pos_) < length)) grow(length);
+        return *this;
+    }
+
+    /**
+     * @brief Puts a value into a buffer.
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & put(T value)
+    {
+        return put<byte_order>(value);
+    }
+
+    /**
+     * @brief Puts a value into a buffer using given byte order instead
+     * of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_dynamic_buffer &>::type
+    put(T value)
+    {
+        ensure(wire_size<T>::value);
+        Order::encode(value, pos_);
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Copies sequence of bytes into a buffer.
+     * @param from input sequence begin
+     * @param length length of the input sequence
+     * @return current buffer
+     */
+    basic_dynamic_buffer & put(const value_type *from, std::size_t length)
+    {
+        ensure(length);
+        details::copy_sequence(pos_, from, length);
+        pos_ += length;
+        return *this;
+    }
+
+    /**
+     * @brief Copies a fixed-size byte array into a buffer.
+     * @return current buffer
+     */
+    template <std::size_t Length>
+    basic_dynamic_buffer & put(const byte_array<Length> &bytes)
+    {
+        return put(bytes.data, Length);
+    }
+
+    /**
+     * @brief Puts an array of values into a buffer.
+     * @tparam T value type
+     * @param values pointer to the first value
+     * @param count number of values to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & put_array(const T *values, std::size_t count)
+    {
+        if (ENCODING_BINARY_UNLIKELY(count > max_size() / sizeof(T))) length_error();
+        ensure(count * sizeof(T));
+        byte_order::encode_array(values, count, pos_);
+        pos_ += count * sizeof(T);
+        return *this;
+    }
+
+    /**
+     * @brief Puts an unsigned LEB128 varint into a buffer.
+     * @tparam T value type, `uint32_t` or `uint64_t`
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & put_varint(T value)
+    {
+        ensure(details::varint_traits<T>::max_size);
+        pos_ += details::encode_varint(value, pos_);
+        return *this;
+    }
+
+    /**
+     * @brief Puts a signed value as a ZigZag-encoded varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value value to put
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & put_svarint(T value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        return put_varint(details::zigzag_encode(bits(value)));
+    }
+
+    /**
+     * @brief Puts a byte sequence preceded by its length.
+     * @tparam Prefix length type: `uint8_t`, `uint16_t`, `uint32_t`,
+     * `uint64_t`, `packed_uint` or `varint_prefix`
+     * @return current buffer
+     */
+    template <typename Prefix>
+    basic_dynamic_buffer & put_blob(const value_type *from, std::size_t length)
+    {
+        typedef details::blob_prefix<Prefix> prefix;
+        if (!prefix::fits(length)) throw_on_overflow::on_overflow();
+        prefix::put(*this, length);
+        return put(from, length);
+    }
+
+    /**
+     * @brief Reserves a zeroed field to be filled in later, e.g. with a
+     * length or a checksum of what follows.
+     * @tparam T field type
+     * @return handle of the field, valid across growth
+     */
+    template <typename T>
+    placeholder<T> put_placeholder()
+    {
+        placeholder<T> field = { size() };
+        put(T());
+        return field;
+    }
+
+    /**
+     * @brief Writes a value into a reserved field. Position doesn't
+     * change.
+     * @tparam T field type
+     * @param field handle returned by `put_placeholder`
+     * @param value value to write
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & fill(placeholder<T> field, T value)
+    {
+        if (!details::placeholder_fits(field, size())) throw_on_overflow::on_overflow();
+        byte_order::encode(value, begin_ + field.offset);
+        return *this;
+    }
+
+    /**
+     * @brief Writes number of bytes put after a reserved field into
+     * the field. A length that doesn't fit `T` is an overflow.
+     * @tparam T field type, an unsigned integer or `packed_uint`
+     * @param field handle returned by `put_placeholder`
+     * @return current buffer
+     */
+    template <typename T>
+    basic_dynamic_buffer & fill_length(placeholder<T> field)
+    {
+        if (!details::placeholder_fits(field, size())
+            || !details::blob_prefix<T>::fits(details::placeholder_length(field, size()))) {
+            throw_on_overflow::on_overflow();
+        }
+        return fill(field, T(details::placeholder_length(field, size())));
+    }
+
+    /**
+     * @brief Grows the buffer once so `length` bytes fit and returns an
+     * unchecked window over them. Buffer position moves when the
+     * window is destroyed.
+     * @param length number of bytes to reserve
+     * @return window over the reserved bytes
+     */
+    basic_window<byte_order, access_tag> reserve(std::size_t length)
+    {
+        ensure(length);
+        return basic_window<byte_order, access_tag>(pos_, length);
+    }
+
+    /**
+     * @brief Hands the written bytes off to the caller, who becomes
+     * responsible for freeing them. Bytes still in the inline region
+     * are moved to the heap first, unless there are none: then the
+     * storage is empty and nothing is allocated. The buffer becomes
+     * empty.
+     * @return storage holding the written bytes
+     */
+    dynamic_storage release()
+    {
+        if (is_inline()) {
+            if (size() == 0) {
+                dynamic_storage empty = { 0, 0, 0 };
+                return empty;
+            }
+            reallocate(size());
+        }
+        dynamic_storage storage = { begin_, size(), capacity() };
+        begin_ = pos_ = inline_;
+        end_ = inline_ + InlineSize;
+        return storage;
+    }
+
+private:
+    basic_dynamic_buffer(const basic_dynamic_buffer &);
+    basic_dynamic_buffer & operator=(const basic_dynamic_buffer &);
+
+    ENCODING_BINARY_NOINLINE void grow(std::size_t length)
+    {
+        const std::size_t limit = max_size();
+        if (length > limit - size()) length_error();
+        const std::size_t required = size() + length;
+        const std::size_t doubled = capacity() > limit / 2 ? limit : 2 * capacity();
+        reallocate(doubled < required ? required : doubled);
+    }
+
+    ENCODING_BINARY_NOINLINE static void length_error()
+    {
+#if ENCODING_BINARY_HAS_EXCEPTIONS
+        throw std::length_error("Dynamic buffer is too large");
+#else
+        std::abort();
+#endif
+    }
+
+    void reallocate(std::size_t capacity)
+    {
+        uint8_t *storage = Allocator::allocate(capacity);
+        const std::size_t written = size();
+        if (written) std::memcpy(storage, begin_, written);
+        deallocate();
+        begin_ = storage;
+        pos_ = storage + written;
+        end_ = storage + capacity;
+    }
+
+    // Leaves `other` empty and inline. Heap storage changes hands,
+    // inline bytes are copied and the position is re-pointed.
+    void take(basic_dynamic_buffer &other)
+    {
+        const std::size_t written = other.size();
+        if (other.is_inline()) {
+            if (written) std::memcpy(inline_, other.inline_, written);
+            begin_ = inline_;
+            end_ = inline_ + InlineSize;
+        } else {
+            begin_ = other.begin_;
+            end_ = other.end_;
+        }
+        pos_ = begin_ + written;
+        other.begin_ = other.pos_ = other.inline_;
+        other.end_ = other.inline_ + InlineSize;
+    }
+
+    void deallocate()
+    {
+        if (!is_inline()) Allocator::deallocate(begin_, capacity());
+    }
+
+    iterator begin_;
+    iterator end_;
+    iterator pos_;
+    uint8_t inline_[InlineSize ? InlineSize : 1];   // no zero-length arrays
+};
+
+/**
+ * @brief Growable buffer with network byte order.
+ */
+typedef basic_dynamic_buffer<> dynamic_buffer;
+
+/**
+ * @brief Growable buffer with little-endian byte order.
+ */
+typedef basic_dynamic_buffer<little_endian> le_dynamic_buffer;
+
+template <
+    typename ByteOrder,
+    std::size_t InlineSize,
+    typename Allocator,
+    typename T
+    >
+basic_dynamic_buffer<ByteOrder, InlineSize, Allocator> &
+operator<<(basic_dynamic_buffer<ByteOrder, InlineSize, Allocator> &buf, const T &value) {
+    return buf.put(value);
+}
+
+} }
+
+#endif /* ENCODING_BINARY_DYNAMIC_BUFFER_H_ */
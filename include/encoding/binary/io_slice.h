@@ -0,0 +1,65 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_IO_SLICE_H_
+#define ENCODING_BINARY_IO_SLICE_H_
+
+#include <cstddef>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/uio.h>
+#endif
+
+/**
+ * @file
+ * @brief Description of a contiguous piece of memory used for
+ * scatter/gather I/O.
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Contiguous piece of input or output. On POSIX systems it's
+ * `struct iovec`, so arrays of slices can be passed to `writev`,
+ * `readv`, `sendmsg` and `recvmsg` directly.
+ */
+#if defined(__unix__) || defined(__APPLE__)
+typedef ::iovec io_slice;
+#else
+struct io_slice {
+    void *iov_base;
+    std::size_t iov_len;
+};
+#endif
+
+} }
+
+#endif /* ENCODING_BINARY_IO_SLICE_H_ */
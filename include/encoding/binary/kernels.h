@@ -0,0 +1,410 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_KERNELS_H_
+#define ENCODING_BINARY_KERNELS_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include "encoding/binary/config.h"
+#include "encoding/binary/byte_swap.h"
+#include "encoding/binary/cpu.h"
+
+#if ENCODING_BINARY_RUNTIME_DISPATCH || ENCODING_BINARY_HAS_AVX2 || ENCODING_BINARY_HAS_AVX512
+#  include <immintrin.h>
+#elif ENCODING_BINARY_HAS_SSSE3
+#  include <tmmintrin.h>
+#elif ENCODING_BINARY_HAS_SSE2
+#  include <emmintrin.h>
+#endif
+
+/**
+ * @file
+ * @brief Bulk kernels converting arrays of values between host and
+ * foreign byte order, copying large byte sequences and computing
+ * prefix sums.
+ *
+ * Every kernel processes as many full vector blocks as possible
+ * using the widest instruction set returned by `active_cpu_level()`
+ * and finishes the rest with a scalar tail. Source and destination are
+ * plain byte pointers without alignment requirements.
+ */
+namespace encoding { namespace binary { namespace details {
+
+/**
+ * @brief Scalar tail: swaps bytes of `count` values of type `T`.
+ */
+template <typename T>
+inline void swap_array_scalar(const uint8_t *src, uint8_t *dst, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        store(byte_swap(load<T>(src + i * sizeof(T))), dst + i * sizeof(T));
+    }
+}
+
+#if ENCODING_BINARY_HAS_SSE2
+
+/**
+ * @brief SSE2 has no byte shuffle, so bytes are swapped with shifts
+ * after 16-bit words were put in place.
+ */
+template <typename T> struct sse2_swap;
+
+template <> struct sse2_swap<uint16_t> {
+    ENCODING_BINARY_TARGET("sse2") static __m128i apply(__m128i v) {
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+};
+template <> struct sse2_swap<uint32_t> {
+    ENCODING_BINARY_TARGET("sse2") static __m128i apply(__m128i v) {
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+        return sse2_swap<uint16_t>::apply(v);
+    }
+};
+template <> struct sse2_swap<uint64_t> {
+    ENCODING_BINARY_TARGET("sse2") static __m128i apply(__m128i v) {
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1b), 0x1b);
+        return sse2_swap<uint16_t>::apply(v);
+    }
+};
+
+template <typename T>
+ENCODING_BINARY_TARGET("sse2")
+inline std::size_t swap_blocks_sse2(const uint8_t *src, uint8_t *dst, std::size_t bytes)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), sse2_swap<T>::apply(v));
+    }
+    return i;
+}
+
+#endif
+
+/**
+ * @brief Byte indices reversing each `T` inside 16-byte lanes,
+ * repeated for every lane of a 512-bit register.
+ */
+template <typename T>
+struct swap_shuffle;
+
+template <> struct swap_shuffle<uint16_t> {
+    static const uint8_t *indices() {
+        static const uint8_t idx[64] = {
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+        };
+        return idx;
+    }
+};
+template <> struct swap_shuffle<uint32_t> {
+    static const uint8_t *indices() {
+        static const uint8_t idx[64] = {
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+        };
+        return idx;
+    }
+};
+template <> struct swap_shuffle<uint64_t> {
+    static const uint8_t *indices() {
+        static const uint8_t idx[64] = {
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+        };
+        return idx;
+    }
+};
+
+#if ENCODING_BINARY_HAS_SSSE3
+
+template <typename T>
+ENCODING_BINARY_TARGET("ssse3")
+inline std::size_t swap_blocks_ssse3(const uint8_t *src, uint8_t *dst, std::size_t bytes)
+{
+    const __m128i mask = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(swap_shuffle<T>::indices()));
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+#endif
+
+#if ENCODING_BINARY_HAS_AVX2
+
+template <typename T>
+ENCODING_BINARY_TARGET("avx2")
+inline std::size_t swap_blocks_avx2(const uint8_t *src, uint8_t *dst, std::size_t bytes)
+{
+    const __m256i mask = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(swap_shuffle<T>::indices()));
+    std::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+#endif
+
+#if ENCODING_BINARY_HAS_AVX512
+
+template <typename T>
+ENCODING_BINARY_TARGET("avx512bw")
+inline std::size_t swap_blocks_avx512(const uint8_t *src, uint8_t *dst, std::size_t bytes)
+{
+    const __m512i mask = _mm512_loadu_si512(swap_shuffle<T>::indices());
+    std::size_t i = 0;
+    for (; i + 64 <= bytes; i += 64) {
+        const __m512i v = _mm512_loadu_si512(src + i);
+        _mm512_storeu_si512(dst + i, _mm512_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+#endif
+
+/**
+ * @brief Reverses bytes of each of `count` values of type `T` while
+ * copying them from `src` to `dst`.
+ */
+template <typename T>
+inline void swap_array(const uint8_t *src, uint8_t *dst, std::size_t count)
+{
+    const std::size_t bytes = count * sizeof(T);
+    std::size_t done = 0;
+    switch (active_cpu_level()) {
+#if ENCODING_BINARY_HAS_AVX512
+    case cpu_level_avx512: done = swap_blocks_avx512<T>(src, dst, bytes); break;
+#endif
+#if ENCODING_BINARY_HAS_AVX2
+    case cpu_level_avx2: done = swap_blocks_avx2<T>(src, dst, bytes); break;
+#endif
+#if ENCODING_BINARY_HAS_SSSE3
+    case cpu_level_ssse3: done = swap_blocks_ssse3<T>(src, dst, bytes); break;
+#endif
+#if ENCODING_BINARY_HAS_SSE2
+    case cpu_level_sse2: done = swap_blocks_sse2<T>(src, dst, bytes); break;
+#endif
+    default: break;
+    }
+    const std::size_t head = done / sizeof(T);
+    swap_array_scalar<T>(src + done, dst + done, count - head);
+}
+
+#if ENCODING_BINARY_HAS_SSE2
+
+/**
+ * @brief Copies `length` bytes with non-temporal stores that bypass
+ * the cache. Stores are 16-byte aligned, loads are not.
+ */
+ENCODING_BINARY_TARGET("sse2")
+inline void stream_copy_sse2(uint8_t *dst, const uint8_t *src, std::size_t length)
+{
+    std::size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    if (head > length) head = length;
+    std::memcpy(dst, src, head);
+    std::size_t i = head;
+    for (; i + 64 <= length; i += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+    }
+    _mm_sfence();
+    std::memcpy(dst + i, src + i, length - i);
+}
+
+#endif
+
+/**
+ * @brief Copies a byte sequence into a buffer: `memcpy` for regular
+ * sizes, non-temporal stores from `ENCODING_BINARY_STREAMING_THRESHOLD`
+ * bytes on.
+ */
+inline void copy_sequence(uint8_t *dst, const uint8_t *src, std::size_t length)
+{
+#if ENCODING_BINARY_HAS_SSE2 && ENCODING_BINARY_STREAMING_THRESHOLD > 0
+    if (length >= ENCODING_BINARY_STREAMING_THRESHOLD && active_cpu_level() >= cpu_level_sse2) {
+        stream_copy_sse2(dst, src, length);
+        return;
+    }
+#endif
+    std::memcpy(dst, src, length);
+}
+
+/**
+ * @brief Scalar tail: replaces `count` values with their running sum
+ * starting from `sum`.
+ * @return last sum
+ */
+template <typename T>
+inline T prefix_sum_scalar(T *values, std::size_t count, T sum)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        sum = T(sum + values[i]);
+        values[i] = sum;
+    }
+    return sum;
+}
+
+#if ENCODING_BINARY_HAS_SSE2
+
+/**
+ * @brief In-register scan of a 16-byte block: each lane gets the sum
+ * of itself and all lanes below it, plus the carry of the previous
+ * block broadcast to every lane.
+ */
+template <typename T> struct sse2_scan;
+
+template <> struct sse2_scan<uint32_t> {
+    ENCODING_BINARY_TARGET("sse2") static __m128i apply(__m128i v, __m128i carry) {
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        return _mm_add_epi32(v, carry);
+    }
+    ENCODING_BINARY_TARGET("sse2") static __m128i broadcast_last(__m128i v) {
+        return _mm_shuffle_epi32(v, 0xff);
+    }
+    ENCODING_BINARY_TARGET("sse2") static __m128i broadcast(uint32_t x) {
+        return _mm_set1_epi32(int(x));
+    }
+};
+
+template <> struct sse2_scan<uint64_t> {
+    ENCODING_BINARY_TARGET("sse2") static __m128i apply(__m128i v, __m128i carry) {
+        v = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+        return _mm_add_epi64(v, carry);
+    }
+    ENCODING_BINARY_TARGET("sse2") static __m128i broadcast_last(__m128i v) {
+        return _mm_unpackhi_epi64(v, v);
+    }
+    ENCODING_BINARY_TARGET("sse2") static __m128i broadcast(uint64_t x) {
+        return _mm_set1_epi64x(static_cast<long long>(x));
+    }
+};
+
+template <typename T>
+ENCODING_BINARY_TARGET("sse2")
+inline std::size_t prefix_sum_sse2(T *values, std::size_t count, T &sum)
+{
+    const std::size_t lanes = 16 / sizeof(T);
+    __m128i carry = sse2_scan<T>::broadcast(sum);
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+        __m128i *block = reinterpret_cast<__m128i*>(values + i);
+        const __m128i v = sse2_scan<T>::apply(_mm_loadu_si128(block), carry);
+        _mm_storeu_si128(block, v);
+        carry = sse2_scan<T>::broadcast_last(v);
+    }
+    if (i) sum = values[i - 1];
+    return i;
+}
+
+#endif
+
+/**
+ * @brief Replaces `count` unsigned values with their running sum
+ * starting from `sum`, wrapping around on overflow.
+ * @return last sum
+ */
+template <typename T>
+inline T prefix_sum(T *values, std::size_t count, T sum)
+{
+    std::size_t done = 0;
+#if ENCODING_BINARY_HAS_SSE2
+    if (active_cpu_level() >= cpu_level_sse2) done = prefix_sum_sse2(values, count, sum);
+#endif
+    return prefix_sum_scalar(values + done, count - done, sum);
+}
+
+/**
+ * @brief Copies `count` values of type `T` from `src` to `dst`,
+ * reversing their bytes if `Swap` is true.
+ */
+template <bool Swap, typename T>
+struct array_copier {
+    static void apply(const uint8_t *src, uint8_t *dst, std::size_t count) {
+        swap_array<T>(src, dst, count);
+    }
+};
+
+template <typename T>
+struct array_copier<false, T> {
+    static void apply(const uint8_t *src, uint8_t *dst, std::size_t count) {
+        std::memcpy(dst, src, count * sizeof(T));
+    }
+};
+
+// Single bytes have nothing to swap.
+template <>
+struct array_copier<true, uint8_t> : array_copier<false, uint8_t> {};
+
+/**
+ * @brief Bulk encoding routines shared by byte order strategies.
+ * Signed and floating point arrays go through the kernels of the
+ * unsigned type of the same size.
+ * @tparam Swap whether the strategy differs from host byte order
+ */
+template <bool Swap>
+struct array_codec {
+    template <typename T>
+    static void encode_array(const T *values, std::size_t count, uint8_t *buf) {
+        typedef typename representation<T>::type bits;
+        array_copier<Swap, bits>::apply(reinterpret_cast<const uint8_t*>(values), buf, count);
+    }
+    template <typename T>
+    static void decode_array(const uint8_t *buf, std::size_t count, T *values) {
+        typedef typename representation<T>::type bits;
+        array_copier<Swap, bits>::apply(buf, reinterpret_cast<uint8_t*>(values), count);
+    }
+};
+
+} } }
+
+#endif /* ENCODING_BINARY_KERNELS_H_ */
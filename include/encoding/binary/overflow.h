@@ -0,0 +1,129 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_OVERFLOW_H_
+#define ENCODING_BINARY_OVERFLOW_H_
+
+#include <cstdlib>
+#include <stdexcept>
+#include "encoding/binary/config.h"
+
+/**
+ * @file
+ * @brief Policies that decide what happens when an operation doesn't
+ * fit into a buffer or finds malformed input.
+ *
+ * A policy is a base class of a buffer. It provides `on_overflow()`
+ * and `on_malformed()`, called on the cold path, `overflowed()`,
+ * which tells whether any operation has failed so far, and
+ * `stops_on_overflow`, which is true when the hooks never return.
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Throws `std::out_of_range` on overflow and
+ * `std::invalid_argument` on malformed input. This is the default
+ * policy. Without exception support it aborts instead.
+ */
+struct throw_on_overflow {
+    ENCODING_BINARY_NOINLINE static void on_overflow()
+    {
+#if ENCODING_BINARY_HAS_EXCEPTIONS
+        throw std::out_of_range("Buffer out of bounds");
+#else
+        std::abort();
+#endif
+    }
+
+    ENCODING_BINARY_NOINLINE static void on_malformed()
+    {
+#if ENCODING_BINARY_HAS_EXCEPTIONS
+        throw std::invalid_argument("Malformed input");
+#else
+        std::abort();
+#endif
+    }
+
+    static bool overflowed() { return false; }
+
+    static const bool stops_on_overflow = true;
+};
+
+/**
+ * @brief Aborts the program. Handy for `-fno-exceptions` builds
+ * where running out of space is a bug.
+ */
+struct abort_on_overflow {
+    ENCODING_BINARY_NOINLINE static void on_overflow()
+    {
+        std::abort();
+    }
+
+    ENCODING_BINARY_NOINLINE static void on_malformed()
+    {
+        std::abort();
+    }
+
+    static bool overflowed() { return false; }
+
+    static const bool stops_on_overflow = true;
+};
+
+/**
+ * @brief Remembers the failure in a flag and lets the encoder go on.
+ * Malformed input counts as a failure too.
+ *
+ * A failed operation moves the buffer to its end, so every operation
+ * that follows fails too and nothing is written or read out of
+ * order. Check `overflowed()` once at the end of a message; values
+ * read after the failure are left untouched.
+ */
+class sticky_overflow {
+public:
+    sticky_overflow() : overflowed_(false) {}
+
+    void on_overflow() { overflowed_ = true; }
+
+    void on_malformed() { overflowed_ = true; }
+
+    bool overflowed() const { return overflowed_; }
+
+    void clear_overflow() { overflowed_ = false; }
+
+    static const bool stops_on_overflow = false;
+
+private:
+    bool overflowed_;
+};
+
+} }
+
+#endif /* ENCODING_BINARY_OVERFLOW_H_ */
@@ -0,0 +1,358 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_SEGMENTED_BUFFER_H_
+#define ENCODING_BINARY_SEGMENTED_BUFFER_H_
+
+#include "encoding/binary/buffer.h"
+#include "encoding/binary/io_slice.h"
+
+/**
+ * @file
+ * @brief Reading buffer over a sequence of non-contiguous segments.
+ * @author Roman Kashitsyn
+ */
+namespace encoding { namespace binary {
+
+/**
+ * @brief Reading buffer over an array of `io_slice` segments, e.g.
+ * the ones filled by `readv` or `recvmsg`. Segments are read in place,
+ * without gathering them into a contiguous array first.
+ *
+ * Values that fit into the current segment are decoded in place,
+ * exactly like in `basic_buffer`. Values straddling a segment boundary
+ * are assembled in a small scratch area first. Empty segments are
+ * allowed. The segment array must outlive the buffer.
+ *
+ * @tparam ByteOrder byte order used for decoding
+ * @tparam OverflowPolicy what to do when a value doesn't fit
+ */
+template <
+    typename ByteOrder = default_byte_order,
+    typename OverflowPolicy = throw_on_overflow
+    >
+class basic_segmented_buffer : public OverflowPolicy
+{
+public:
+    typedef ByteOrder byte_order;
+    typedef OverflowPolicy overflow_policy;
+    typedef read_access_tag access_tag;
+    typedef access_traits<access_tag>::value_type value_type;
+    typedef access_traits<access_tag>::const_iterator const_iterator;
+
+    basic_segmented_buffer(const io_slice *segments, std::size_t count)
+    {
+        assign(segments, count);
+    }
+
+    /**
+     * @brief Retargets buffer to a new array of segments. State of the
+     * overflow policy is kept.
+     * @return current buffer
+     */
+    basic_segmented_buffer & assign(const io_slice *segments, std::size_t count)
+    {
+        next_ = segments;
+        last_ = segments + count;
+        pos_ = end_ = 0;
+        rest_ = 0;
+        for (std::size_t i = 0; i < count; ++i) rest_ += segments[i].iov_len;
+        return *this;
+    }
+
+    /**
+     * @brief Returns number of bytes left in all segments.
+     */
+    std::size_t bytes_left() const
+    {
+        return std::size_t(end_ - pos_) + rest_;
+    }
+
+    /**
+     * @brief Reads a value from a buffer.
+     * @tparam T value type
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename T>
+    basic_segmented_buffer & get(T &value)
+    {
+        return get<byte_order>(value);
+    }
+
+    /**
+     * @brief Reads a value from a buffer using given byte order instead
+     * of the buffer's one.
+     * @tparam Order byte order for this value only
+     * @tparam T value type
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename Order, typename T>
+    typename details::enable_if<details::is_byte_order<Order>::value, basic_segmented_buffer &>::type
+    get(T &value)
+    {
+        const std::size_t available = std::size_t(end_ - pos_);
+        if (ENCODING_BINARY_UNLIKELY(available < wire_size<T>::value)) return get_split<Order>(value);
+        details::slack_decoder<T>::template decode<Order>(pos_, available, value);
+        pos_ += wire_size<T>::value;
+        return *this;
+    }
+
+    /**
+     * @brief Reads a sequence of bytes from a buffer, gathering it from
+     * as many segments as needed.
+     * @param dst destination byte sequence
+     * @param length length of the output sequence
+     * @return current buffer
+     */
+    basic_segmented_buffer & get(value_type *dst, std::size_t length)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < length)) return overflow();
+        copy_out(dst, length);
+        return *this;
+    }
+
+    /**
+     * @brief Reads an array of values from a buffer. Values that lie
+     * within one segment are converted in bulk.
+     * @tparam T value type
+     * @param values pointer to the first value of destination array
+     * @param count number of values to read
+     * @return current buffer
+     */
+    template <typename T>
+    basic_segmented_buffer & get_array(T *values, std::size_t count)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() / sizeof(T) < count)) return overflow();
+        while (count) {
+            std::size_t n = std::size_t(end_ - pos_) / sizeof(T);
+            if (n == 0) {
+                get(*values++);
+                --count;
+                continue;
+            }
+            if (n > count) n = count;
+            byte_order::decode_array(pos_, n, values);
+            pos_ += n * sizeof(T);
+            values += n;
+            count -= n;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint from a buffer. Varints
+     * that are too long or don't fit `T` are reported as malformed.
+     * @tparam T value type, `uint32_t` or `uint64_t`
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename T>
+    basic_segmented_buffer & get_varint(T &value)
+    {
+        read_varint(value);
+        return *this;
+    }
+
+    /**
+     * @brief Reads a ZigZag-encoded signed varint.
+     * @tparam T value type, `int32_t` or `int64_t`
+     * @param value reference to value
+     * @return current buffer
+     */
+    template <typename T>
+    basic_segmented_buffer & get_svarint(T &value)
+    {
+        typedef typename details::zigzag_traits<T>::type bits;
+        bits zigzag = 0;
+        if (read_varint(zigzag)) value = T(details::zigzag_decode(zigzag));
+        return *this;
+    }
+
+    /**
+     * @brief Moves the position `count` bytes forward.
+     * @return current buffer
+     */
+    basic_segmented_buffer & skip(std::size_t count)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < count)) return overflow();
+        for (;;) {
+            const std::size_t available = std::size_t(end_ - pos_);
+            if (count <= available) break;
+            count -= available;
+            next_segment();
+        }
+        pos_ += count;
+        return *this;
+    }
+
+private:
+    // Returns false if the varint was reported as an overflow or as
+    // malformed.
+    template <typename T>
+    bool read_varint(T &value)
+    {
+        std::size_t size;
+        if (std::size_t(end_ - pos_) >= details::varint_fast_bytes) {
+            size = details::decode_varint_fast(pos_, value);
+        } else {
+            uint8_t bytes[details::varint_traits<T>::max_size];
+            std::size_t available = bytes_left();
+            if (available > sizeof(bytes)) available = sizeof(bytes);
+            peek_out(bytes, available);
+            size = details::decode_varint_slow(bytes, available, value);
+            if (ENCODING_BINARY_UNLIKELY(size == 0)) {
+                overflow();
+                return false;
+            }
+            if (ENCODING_BINARY_UNLIKELY(size == details::varint_malformed)) {
+                malformed();
+                return false;
+            }
+            skip(size);
+            return true;
+        }
+        if (ENCODING_BINARY_UNLIKELY(size == details::varint_malformed)) {
+            malformed();
+            return false;
+        }
+        pos_ += size;
+        return true;
+    }
+
+    // Copies byte by byte instead of calling memcpy: a call anywhere in
+    // a decoding loop makes GCC reload the position from memory after
+    // every value, which puts a store-to-load round trip on the
+    // critical path.
+    template <typename Order, typename T>
+    basic_segmented_buffer & get_split(T &value)
+    {
+        if (ENCODING_BINARY_UNLIKELY(bytes_left() < wire_size<T>::value)) return overflow();
+        uint8_t bytes[wire_size<T>::value];
+        for (std::size_t i = 0; i < wire_size<T>::value; ++i) {
+            while (pos_ == end_) next_segment();
+            bytes[i] = *pos_++;
+        }
+        Order::decode(bytes, value);
+        return *this;
+    }
+
+    void next_segment()
+    {
+        pos_ = static_cast<const_iterator>(next_->iov_base);
+        end_ = pos_ + next_->iov_len;
+        rest_ -= next_->iov_len;
+        ++next_;
+    }
+
+    // Callers check that `length` bytes are left.
+    void copy_out(uint8_t *dst, std::size_t length)
+    {
+        while (length) {
+            while (pos_ == end_) next_segment();
+            const std::size_t available = std::size_t(end_ - pos_);
+            const std::size_t n = length < available ? length : available;
+            std::memcpy(dst, pos_, n);
+            pos_ += n;
+            dst += n;
+            length -= n;
+        }
+    }
+
+    // Same as `copy_out`, but leaves the position alone.
+    void peek_out(uint8_t *dst, std::size_t length) const
+    {
+        const_iterator pos = pos_;
+        const_iterator end = end_;
+        const io_slice *next = next_;
+        while (length) {
+            while (pos == end) {
+                pos = static_cast<const_iterator>(next->iov_base);
+                end = pos + next->iov_len;
+                ++next;
+            }
+            const std::size_t available = std::size_t(end - pos);
+            const std::size_t n = length < available ? length : available;
+            std::memcpy(dst, pos, n);
+            pos += n;
+            dst += n;
+            length -= n;
+        }
+    }
+
+    void drain()
+    {
+        pos_ = end_;
+        next_ = last_;
+        rest_ = 0;
+    }
+
+    basic_segmented_buffer & overflow()
+    {
+        overflow_policy::on_overflow();
+        drain();
+        return *this;
+    }
+
+    basic_segmented_buffer & malformed()
+    {
+        overflow_policy::on_malformed();
+        drain();
+        return *this;
+    }
+
+    const io_slice *next_;
+    const io_slice *last_;
+    const_iterator pos_;
+    const_iterator end_;
+    std::size_t rest_;   // bytes in segments after the current one
+};
+
+/**
+ * @brief Segmented buffer with network byte order.
+ */
+typedef basic_segmented_buffer<> segmented_buffer;
+
+/**
+ * @brief Segmented buffer with little-endian byte order.
+ */
+typedef basic_segmented_buffer<little_endian> le_segmented_buffer;
+
+template <typename ByteOrder, typename OverflowPolicy, typename T>
+basic_segmented_buffer<ByteOrder, OverflowPolicy> &
+operator>>(basic_segmented_buffer<ByteOrder, OverflowPolicy> &buf, T &value) {
+    return buf.get(value);
+}
+
+} }
+
+#endif /* ENCODING_BINARY_SEGMENTED_BUFFER_H_ */
@@ -0,0 +1,358 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_STREAM_VBYTE_H_
+#define ENCODING_BINARY_STREAM_VBYTE_H_
+
+#include "encoding/binary/buffer.h"
+
+/**
+ * @file
+ * @brief Stream VByte codec for arrays of `uint32_t`.
+ *
+ * An array of `count` values is stored as two streams: `(count + 3) / 4`
+ * control bytes followed by data bytes. Each control byte describes
+ * four values, two bits per value starting from the low bits, holding
+ * the number of data bytes of the value minus one. Data bytes are
+ * little-endian.
+ *
+ * Since lengths of four values are known from one control byte, the
+ * decoder expands them with a single byte shuffle whose mask is
+ * looked up in a table indexed by the control byte.
+ */
+namespace encoding { namespace binary {
+
+namespace details {
+
+/**
+ * @brief Lookup tables of the decoder, built on first use: number of
+ * data bytes and shuffle mask expanding them into four `uint32_t`
+ * for every control byte.
+ */
+struct svb_tables {
+    uint8_t length[256];
+    uint8_t shuffle[256][16];
+
+    svb_tables()
+    {
+        for (unsigned c = 0; c < 256; ++c) {
+            unsigned offset = 0;
+            for (unsigned k = 0; k < 4; ++k) {
+                const unsigned len = ((c >> (2 * k)) & 3) + 1;
+                for (unsigned b = 0; b < 4; ++b) {
+                    shuffle[c][4 * k + b] = uint8_t(b < len ? offset + b : 0x80);
+                }
+                offset += len;
+            }
+            length[c] = uint8_t(offset);
+        }
+    }
+
+    static const svb_tables & get()
+    {
+        static const svb_tables tables;
+        return tables;
+    }
+};
+
+/**
+ * @brief Returns the 2-bit length code of `value`.
+ */
+inline unsigned svb_code(uint32_t value)
+{
+    return unsigned(value > 0xff) + unsigned(value > 0xffff) + unsigned(value > 0xffffff);
+}
+
+/**
+ * @brief Returns number of control bytes for `count` values.
+ */
+inline std::size_t svb_control_size(std::size_t count)
+{
+    return (count + 3) / 4;
+}
+
+/**
+ * @brief Returns number of data bytes described by control bytes of
+ * `count` values.
+ */
+inline std::size_t svb_data_size(const uint8_t *ctrl, std::size_t count)
+{
+    const svb_tables &tables = svb_tables::get();
+    std::size_t size = 0;
+    for (std::size_t q = 0; q < count / 4; ++q) size += tables.length[ctrl[q]];
+    for (std::size_t k = 0; k < count % 4; ++k) size += ((ctrl[count / 4] >> (2 * k)) & 3) + 1;
+    return size;
+}
+
+/**
+ * @brief Encodes `count` values into `capacity` bytes at `dst`, which
+ * must be enough for the encoding.
+ * @return number of bytes written
+ */
+inline std::size_t svb_encode(const uint32_t *values, std::size_t count,
+                              uint8_t *dst, std::size_t capacity)
+{
+    uint8_t *const ctrl = dst;
+    const std::size_t ctrl_size = svb_control_size(count);
+    std::memset(ctrl, 0, ctrl_size);
+    uint8_t *data = dst + ctrl_size;
+    const uint8_t *const end = dst + capacity;
+    for (std::size_t i = 0; i < count; ++i) {
+        const unsigned code = svb_code(values[i]);
+        ctrl[i / 4] = uint8_t(ctrl[i / 4] | code << (2 * (i % 4)));
+        // Storing all four bytes is cheaper than storing exactly
+        // `code + 1` of them; the extra bytes are overwritten next.
+        if (ENCODING_BINARY_UNLIKELY(end - data < 4)) {
+            store_prefix(to_little(values[i]), data, code + 1);
+        } else {
+            store(to_little(values[i]), data);
+        }
+        data += code + 1;
+    }
+    return std::size_t(data - dst);
+}
+
+/**
+ * @brief Decodes value `k` of the quad described by control byte `c`.
+ */
+inline uint32_t svb_decode_one(uint8_t c, unsigned k, const uint8_t *&data)
+{
+    const std::size_t len = ((c >> (2 * k)) & 3) + 1;
+    const uint32_t value = to_little(load_prefix<uint32_t>(data, len));
+    data += len;
+    return value;
+}
+
+#if ENCODING_BINARY_HAS_SSSE3
+
+ENCODING_BINARY_TARGET("ssse3")
+inline std::size_t svb_decode_quads_ssse3(const uint8_t *ctrl, const uint8_t *&data,
+                                          const uint8_t *data_end, uint32_t *out,
+                                          std::size_t quads)
+{
+    const svb_tables &tables = svb_tables::get();
+    std::size_t q = 0;
+    for (; q < quads && data_end - data >= 16; ++q) {
+        const uint8_t c = ctrl[q];
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.shuffle[c]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * q), _mm_shuffle_epi8(bytes, mask));
+        data += tables.length[c];
+    }
+    return q;
+}
+
+#endif
+
+#if ENCODING_BINARY_HAS_AVX2
+
+ENCODING_BINARY_TARGET("avx2")
+inline std::size_t svb_decode_quads_avx2(const uint8_t *ctrl, const uint8_t *&data,
+                                         const uint8_t *data_end, uint32_t *out,
+                                         std::size_t quads)
+{
+    const svb_tables &tables = svb_tables::get();
+    std::size_t q = 0;
+    for (; q + 2 <= quads && data_end - data >= 32; q += 2) {
+        const uint8_t c0 = ctrl[q], c1 = ctrl[q + 1];
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const __m128i hi = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + tables.length[c0]));
+        const __m128i mlo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.shuffle[c0]));
+        const __m128i mhi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.shuffle[c1]));
+        const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        const __m256i mask = _mm256_inserti128_si256(_mm256_castsi128_si256(mlo), mhi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * q),
+                            _mm256_shuffle_epi8(bytes, mask));
+        data += tables.length[c0] + tables.length[c1];
+    }
+    return q;
+}
+
+#endif
+
+/**
+ * @brief Decodes `count` values starting at a control byte boundary.
+ * Full quads are expanded with the widest shuffle available while at
+ * least a vector of data is left; the rest is decoded one by one.
+ * @return pointer past the last data byte consumed
+ */
+inline const uint8_t * svb_decode(const uint8_t *ctrl, const uint8_t *data,
+                                  const uint8_t *data_end, uint32_t *out, std::size_t count)
+{
+    const std::size_t quads = count / 4;
+    std::size_t done = 0;
+    (void) quads;
+    (void) data_end;
+    switch (active_cpu_level()) {
+#if ENCODING_BINARY_HAS_AVX2
+    case cpu_level_avx512:
+    case cpu_level_avx2:
+        done = svb_decode_quads_avx2(ctrl, data, data_end, out, quads);
+        done += svb_decode_quads_ssse3(ctrl + done, data, data_end, out + 4 * done, quads - done);
+        break;
+#endif
+#if ENCODING_BINARY_HAS_SSSE3
+    case cpu_level_ssse3:
+        done = svb_decode_quads_ssse3(ctrl, data, data_end, out, quads);
+        break;
+#endif
+    default: break;
+    }
+    for (std::size_t i = 4 * done; i < count; ++i) {
+        out[i] = svb_decode_one(ctrl[i / 4], unsigned(i % 4), data);
+    }
+    return data;
+}
+
+}
+
+/**
+ * @brief Returns number of bytes Stream VByte encoding of `values`
+ * takes.
+ */
+inline std::size_t stream_vbyte_size(const uint32_t *values, std::size_t count)
+{
+    std::size_t size = details::svb_control_size(count) + count;
+    for (std::size_t i = 0; i < count; ++i) size += details::svb_code(values[i]);
+    return size;
+}
+
+/**
+ * @brief Puts `count` values in Stream VByte format.
+ * @tparam BufferType writing `basic_buffer` type
+ * @return `buf`
+ */
+template <typename BufferType>
+BufferType & put_stream_vbyte(BufferType &buf, const uint32_t *values, std::size_t count)
+{
+    // Exact size takes another pass over values; skip it when even the
+    // worst case fits.
+    const std::size_t bound = details::svb_control_size(count) + 4 * count;
+    const std::size_t size = buf.bytes_left() >= bound ? 0 : stream_vbyte_size(values, count);
+    if (buf.bytes_left() < size) return buf.skip(size);
+    return buf.skip(details::svb_encode(values, count, buf.pos(), buf.bytes_left()));
+}
+
+/**
+ * @brief Reads `count` values in Stream VByte format.
+ * @tparam BufferType reading `basic_buffer` type
+ * @return `buf`
+ */
+template <typename BufferType>
+BufferType & get_stream_vbyte(BufferType &buf, uint32_t *values, std::size_t count)
+{
+    const std::size_t ctrl_size = details::svb_control_size(count);
+    if (buf.bytes_left() < ctrl_size) return buf.skip(ctrl_size);
+    const uint8_t *const ctrl = buf.pos();
+    const std::size_t size = ctrl_size + details::svb_data_size(ctrl, count);
+    if (buf.bytes_left() < size) return buf.skip(size);
+    details::svb_decode(ctrl, ctrl + ctrl_size, ctrl + size, values, count);
+    return buf.skip(size);
+}
+
+/**
+ * @brief Streaming Stream VByte decoder. The whole encoded array is
+ * taken from a buffer at once, with a single bounds check; values
+ * are then decoded in batches of any size.
+ */
+class stream_vbyte_reader
+{
+public:
+    /**
+     * @brief Takes encoding of `count` values from `buf`. If they don't
+     * fit, the buffer's overflow policy is applied and the reader
+     * stays empty.
+     * @tparam BufferType reading `basic_buffer` type
+     */
+    template <typename BufferType>
+    stream_vbyte_reader(BufferType &buf, std::size_t count)
+        : ctrl_(buf.pos())
+        , data_(buf.pos())
+        , end_(buf.pos())
+        , index_(0)
+        , count_(0)
+    {
+        const std::size_t ctrl_size = details::svb_control_size(count);
+        if (buf.bytes_left() < ctrl_size) {
+            buf.skip(ctrl_size);
+            return;
+        }
+        const std::size_t size = ctrl_size + details::svb_data_size(ctrl_, count);
+        if (buf.bytes_left() < size) {
+            buf.skip(size);
+            return;
+        }
+        data_ = ctrl_ + ctrl_size;
+        end_ = ctrl_ + size;
+        count_ = count;
+        buf.skip(size);
+    }
+
+    /**
+     * @brief Returns number of values not decoded yet.
+     */
+    std::size_t values_left() const { return count_ - index_; }
+
+    /**
+     * @brief Decodes the next value. There must be one left.
+     */
+    uint32_t next()
+    {
+        const std::size_t i = index_++;
+        return details::svb_decode_one(ctrl_[i / 4], unsigned(i % 4), data_);
+    }
+
+    /**
+     * @brief Decodes up to `n` next values into `values`.
+     * @return number of values decoded
+     */
+    std::size_t read(uint32_t *values, std::size_t n)
+    {
+        if (n > values_left()) n = values_left();
+        std::size_t i = 0;
+        for (; i < n && index_ % 4 != 0; ++i) values[i] = next();
+        data_ = details::svb_decode(ctrl_ + index_ / 4, data_, end_, values + i, n - i);
+        index_ += n - i;
+        return n;
+    }
+
+private:
+    const uint8_t *ctrl_;
+    const uint8_t *data_;
+    const uint8_t *end_;
+    std::size_t index_;
+    std::size_t count_;
+};
+
+} }
+
+#endif /* ENCODING_BINARY_STREAM_VBYTE_H_ */
@@ -0,0 +1,245 @@
+// -*- c++ -*-
+
+// Copyright (c) 2013, Roman Kashitsyn
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of the copyright holder nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ENCODING_BINARY_VARINT_H_
+#define ENCODING_BINARY_VARINT_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include "encoding/binary/config.h"
+#include "encoding/binary/byte_swap.h"
+
+#if defined(__BMI2__)
+#  include <immintrin.h>
+#endif
+
+/**
+ * @file
+ * @brief Unsigned LEB128 variable-length integers.
+ *
+ * A value is split into 7-bit groups, least significant group first.
+ * Every byte but the last has its high bit set. Values below 128 take
+ * one byte, a 32-bit value takes at most 5 bytes and a 64-bit value
+ * at most 10.
+ *
+ * Signed values are mapped to unsigned ones with ZigZag encoding
+ * first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...), so small
+ * magnitudes of either sign stay short.
+ *
+ * Decoding loads 8 bytes at once, finds the terminating byte with a
+ * bit trick and compacts the 7-bit groups without branching (with
+ * `pext` when BMI2 is enabled at compile time). Near the end of input
+ * a byte-at-a-time loop takes over.
+ */
+namespace encoding { namespace binary { namespace details {
+
+/**
+ * @brief Varint parameters of a value type. Defined for `uint32_t`
+ * and `uint64_t`.
+ */
+template <typename T> struct varint_traits;
+
+template <> struct varint_traits<uint32_t> {
+    static const std::size_t max_size = 5;
+    static const uint8_t last_byte_limit = 0x0f;
+};
+
+template <> struct varint_traits<uint64_t> {
+    static const std::size_t max_size = 10;
+    static const uint8_t last_byte_limit = 0x01;
+};
+
+/**
+ * @brief Unsigned type used to encode signed varints of type `T`.
+ * Defined for `int32_t` and `int64_t`.
+ */
+template <typename T> struct zigzag_traits;
+
+template <> struct zigzag_traits<int32_t> { typedef uint32_t type; };
+template <> struct zigzag_traits<int64_t> { typedef uint64_t type; };
+
+/**
+ * @brief Maps two's complement bits `n` to ZigZag order.
+ */
+template <typename U>
+inline U zigzag_encode(U n)
+{
+    return U(n << 1) ^ U(U(0) - (n >> (8 * sizeof(U) - 1)));
+}
+
+/**
+ * @brief Maps ZigZag-ordered `z` back to two's complement bits.
+ */
+template <typename U>
+inline U zigzag_decode(U z)
+{
+    return U(z >> 1) ^ U(U(0) - (z & 1));
+}
+
+/**
+ * @brief Input bytes the fast decoder may touch: the longest 64-bit
+ * varint.
+ */
+const std::size_t varint_fast_bytes = 10;
+
+/**
+ * @brief Decoding result meaning the varint is too long or doesn't
+ * fit its type.
+ */
+const std::size_t varint_malformed = ~std::size_t(0);
+
+/**
+ * @brief Returns number of bytes taken by varint encoding of `value`.
+ */
+inline std::size_t varint_size(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (63 - __builtin_clzll(value | 1)) / 7 + 1;
+#else
+    std::size_t size = 1;
+    for (; value >= 0x80; value >>= 7) ++size;
+    return size;
+#endif
+}
+
+/**
+ * @brief Writes varint encoding of `value` to `dst`, which must have
+ * room for `varint_size(value)` bytes.
+ * @return number of bytes written
+ */
+inline std::size_t encode_varint(uint64_t value, uint8_t *dst)
+{
+    std::size_t i = 0;
+    for (; value >= 0x80; value >>= 7) {
+        dst[i++] = uint8_t(value | 0x80);
+    }
+    dst[i++] = uint8_t(value);
+    return i;
+}
+
+/**
+ * @brief Packs the low 7 bits of every byte of `word` into a
+ * 56-bit number, first byte lowest.
+ */
+inline uint64_t compact_varint_groups(uint64_t word)
+{
+#if defined(__BMI2__)
+    return _pext_u64(word, 0x7f7f7f7f7f7f7f7fULL);
+#else
+    word &= 0x7f7f7f7f7f7f7f7fULL;
+    word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+    word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+    return ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+#endif
+}
+
+/**
+ * @brief Returns index of the lowest set bit of nonzero `value`.
+ */
+inline unsigned count_trailing_zeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_ctzll(value));
+#else
+    unsigned n = 0;
+    for (; !(value & 1); value >>= 1) ++n;
+    return n;
+#endif
+}
+
+/**
+ * @brief Decodes a varint from `src`, which must have at least
+ * `varint_fast_bytes` readable bytes.
+ * @return number of bytes consumed or `varint_malformed`
+ */
+template <typename T>
+inline std::size_t decode_varint_fast(const uint8_t *src, T &value)
+{
+    typedef varint_traits<T> traits;
+    // Single-byte values dominate most streams; a predictable branch
+    // keeps them off the load-to-length dependency chain.
+    if (src[0] < 0x80) {
+        value = src[0];
+        return 1;
+    }
+    const uint64_t word = to_little(load<uint64_t>(src));
+    const uint64_t stops = ~word & 0x8080808080808080ULL;
+    if (ENCODING_BINARY_UNLIKELY(stops == 0)) {
+        // Only 64-bit values take 9 or 10 bytes.
+        if (traits::max_size <= 8) return varint_malformed;
+        const uint64_t low = compact_varint_groups(word);
+        if (src[8] < 0x80) {
+            value = T(low | uint64_t(src[8]) << 56);
+            return 9;
+        }
+        if (src[9] > traits::last_byte_limit) return varint_malformed;
+        value = T(low | uint64_t(src[8] & 0x7f) << 56 | uint64_t(src[9]) << 63);
+        return 10;
+    }
+    const std::size_t size = count_trailing_zeros(stops) / 8 + 1;
+    if (size >= traits::max_size && (size > traits::max_size
+                                     || src[size - 1] > traits::last_byte_limit)) {
+        return varint_malformed;
+    }
+    // stops ^ (stops - 1) keeps bits up to the terminating byte.
+    value = T(compact_varint_groups(word & (stops ^ (stops - 1))));
+    return size;
+}
+
+/**
+ * @brief Decodes a varint from `available` bytes at `src` one byte at
+ * a time.
+ * @return number of bytes consumed, 0 if input ends in the middle of
+ * a varint or `varint_malformed`
+ */
+template <typename T>
+inline std::size_t decode_varint_slow(const uint8_t *src, std::size_t available, T &value)
+{
+    typedef varint_traits<T> traits;
+    uint64_t result = 0;
+    for (std::size_t i = 0; i < traits::max_size; ++i) {
+        if (i == available) return 0;
+        const uint8_t byte = src[i];
+        result |= uint64_t(byte & 0x7f) << (7 * i);
+        if (byte < 0x80) {
+            if (i + 1 == traits::max_size && byte > traits::last_byte_limit) {
+                return varint_malformed;
+            }
+            value = T(result);
+            return i + 1;
+        }
+    }
+    return varint_malformed;
+}
+
+} } }
+
+#endif /* ENCODING_BINARY_VARINT_H_ */
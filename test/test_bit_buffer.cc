@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/bit_buffer.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace bin = encoding::binary;
+
+namespace {
+    // 1 | 011 | 00000001010 | 1 => 1011 0000 0001 0101 (0xb0 0x15)
+    const uint8_t Expected[] = {0xb0, 0x15};
+}
+
+TEST(BitBuffer, writes_fields_msb_first)
+{
+    uint8_t cbuf[sizeof(Expected)];
+    bin::writeonly_bit_buffer buf(cbuf);
+    buf.put_bit(true).put_bits(3, 3).put_bits(10, 11).put_bits(1, 1).flush();
+    ASSERT_EQ(16u, buf.bits_written());
+    ASSERT_EQ(0u, buf.bits_left());
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(cbuf)));
+    ASSERT_THROW(buf.put_bit(false), std::out_of_range);
+}
+
+TEST(BitBuffer, reads_fields_msb_first)
+{
+    bin::readonly_bit_buffer buf(Expected);
+    ASSERT_TRUE(buf.get_bit());
+    ASSERT_EQ(3u, buf.get_bits(3));
+    uint16_t length;
+    buf.get_bits(length, 11);
+    ASSERT_EQ(10u, length);
+    ASSERT_EQ(1u, buf.get_bits(1));
+    ASSERT_EQ(0u, buf.bits_left());
+    ASSERT_THROW(buf.get_bit(), std::out_of_range);
+}
+
+TEST(BitBuffer, sticky_overflow)
+{
+    uint8_t cbuf[1];
+    bin::basic_bit_buffer<bin::write_access_tag, bin::sticky_overflow> wr(cbuf);
+    wr.put_bits(5, 3).put_bits(0, 6).put_bit(true);
+    ASSERT_TRUE(wr.overflowed());
+    ASSERT_EQ(0u, wr.bits_left());
+
+    bin::basic_bit_buffer<bin::read_access_tag, bin::sticky_overflow> rd(Expected);
+    uint16_t field = 7;
+    rd.get_bits(field, 17);
+    ASSERT_TRUE(rd.overflowed());
+    ASSERT_EQ(7u, field);
+    ASSERT_EQ(0u, rd.get_bits(1));
+    ASSERT_EQ(0u, rd.bits_left());
+}
+
+TEST(BitBuffer, round_trip_of_many_fields)
+{
+    uint8_t cbuf[512];
+    bin::writeonly_bit_buffer wr(cbuf);
+    uint64_t seed = 1;
+    std::size_t total = 0;
+    for (unsigned i = 0; i < 100; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        const unsigned nbits = unsigned(i * 7 % 65);
+        wr.put_bits(seed, nbits);
+        total += nbits;
+    }
+    wr.flush();
+    ASSERT_EQ((total + 7) / 8 * 8, wr.bits_written());
+
+    bin::readonly_bit_buffer rd(cbuf, (total + 7) / 8);
+    seed = 1;
+    for (unsigned i = 0; i < 100; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        const unsigned nbits = unsigned(i * 7 % 65);
+        const uint64_t mask = nbits == 64 ? ~uint64_t(0) : (uint64_t(1) << nbits) - 1;
+        ASSERT_EQ(seed & mask, rd.get_bits(nbits)) << "field " << i;
+    }
+    ASSERT_EQ(total, rd.bits_read());
+}
+
+TEST(BitBuffer, flush_and_align_move_to_byte_boundary)
+{
+    uint8_t cbuf[3];
+    bin::writeonly_bit_buffer wr(cbuf);
+    wr.put_bits(1, 1).flush().put_bits(0xab, 8).put_bits(1, 2).flush();
+    const uint8_t expected[] = {0x80, 0xab, 0x40};
+    ASSERT_EQ(0, std::memcmp(expected, cbuf, sizeof(cbuf)));
+
+    bin::readonly_bit_buffer rd(cbuf);
+    ASSERT_EQ(1u, rd.get_bits(1));
+    ASSERT_EQ(0xabu, rd.align().get_bits(8));
+}
+
+TEST(StaticBitBuffer, supports_read_write)
+{
+    uint8_t cbuf[10];
+    bin::writeonly_static_bit_buffer<sizeof(cbuf)> wr(cbuf);
+    wr.put_bits<1>(1)
+        .put_bits<3>(3)
+        .put_bits<11>(10)
+        .put_bits<1>(1)
+        .put_bits<60>(0x0123456789abcdefu)
+        .flush();
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+
+    uint8_t flag;
+    uint8_t kind;
+    uint16_t length;
+    uint8_t last;
+    uint64_t big;
+    bin::readonly_static_bit_buffer<sizeof(cbuf)> rd(cbuf);
+    ASSERT_EQ(76u,
+              rd.get_bits<1>(flag)
+              .get_bits<3>(kind)
+              .get_bits<11>(length)
+              .get_bits<1>(last)
+              .get_bits<60>(big)
+              .bits_read());
+    ASSERT_EQ(1u, flag);
+    ASSERT_EQ(3u, kind);
+    ASSERT_EQ(10u, length);
+    ASSERT_EQ(1u, last);
+    ASSERT_EQ(0x0123456789abcdefu, big);
+}
+
+TEST(StaticBitBuffer, keeps_flushed_bits_of_partial_word)
+{
+    uint8_t cbuf[9];
+    bin::writeonly_static_bit_buffer<sizeof(cbuf)> wr(cbuf);
+    wr.put_bits<4>(0xf).flush().put_bits<60>(0).put_bits<4>(0xa).flush();
+    const uint8_t expected[] = {0xf0, 0, 0, 0, 0, 0, 0, 0, 0x0a};
+    ASSERT_EQ(0, std::memcmp(expected, cbuf, sizeof(expected)));
+}
+
+TEST(StaticBitBuffer, flush_at_word_boundary_starts_clean_word)
+{
+    uint8_t cbuf[9];
+    bin::writeonly_static_bit_buffer<sizeof(cbuf)> wr(cbuf);
+    wr.put_bits<60>(0xfffffffffffffffULL).flush().put_bits<8>(0).flush();
+    const uint8_t expected[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0};
+    ASSERT_EQ(0, std::memcmp(expected, cbuf, sizeof(expected)));
+}
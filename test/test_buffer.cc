@@ -2,6 +2,7 @@
 #include "encoding/binary/buffer.h"
 #include <cstring>
 #include <stdexcept>
+#include <vector>
 
 namespace bin = encoding::binary;
 using bin::get;
@@ -156,3 +157,599 @@ TEST(StaticBuffer, supports_read_write)
     ASSERT_EQ(Tail, r_tail);
     ASSERT_EQ(0x0102030405060708u, get<uint64_t>(rd_buf));
 }
+
+TEST(Buffer, unaligned_round_trip_in_both_byte_orders)
+{
+    const uint8_t BigEndian[] = {0xff, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8};
+    const uint8_t LittleEndian[] = {0xff, 0x8, 0x7, 0x6, 0x5, 0x4, 0x3, 0x2, 0x1};
+    uint8_t cbuf[sizeof(BigEndian)];
+
+    bin::buffer be(cbuf);
+    be.put(uint8_t(0xff)).put(uint64_t(0x0102030405060708u));
+    ASSERT_EQ(0, std::memcmp(BigEndian, cbuf, sizeof(cbuf)));
+    be.reset().skip(1);
+    ASSERT_EQ(0x0102u, get<uint16_t>(be));
+    ASSERT_EQ(0x03040506u, get<uint32_t>(be));
+
+    bin::le_buffer le(cbuf);
+    le.put(uint8_t(0xff)).put(uint64_t(0x0102030405060708u));
+    ASSERT_EQ(0, std::memcmp(LittleEndian, cbuf, sizeof(cbuf)));
+    le.reset().skip(1);
+    ASSERT_EQ(0x0708u, get<uint16_t>(le));
+    ASSERT_EQ(0x03040506u, get<uint32_t>(le));
+}
+
+TEST(Buffer, native_endian_works_at_any_offset)
+{
+    uint8_t cbuf[1 + sizeof(uint64_t) + sizeof(uint32_t)];
+    bin::basic_buffer<bin::native_endian> buf(cbuf);
+    buf.put(uint8_t(0)).put(uint64_t(0x0102030405060708u)).put(uint32_t(0x0a0b0c0d));
+
+    uint64_t expected = 0x0102030405060708u;
+    ASSERT_EQ(0, std::memcmp(&expected, cbuf + 1, sizeof(expected)));
+
+    buf.reset().skip(1);
+    ASSERT_EQ(0x0102030405060708u, get<uint64_t>(buf));
+    ASSERT_EQ(0x0a0b0c0du, get<uint32_t>(buf));
+}
+
+TEST(Buffer, aligned_native_endian_matches_native_endian)
+{
+    uint64_t storage[2];
+    uint8_t *cbuf = reinterpret_cast<uint8_t*>(storage);
+    bin::aligned_buffer buf(cbuf, sizeof(storage));
+    buf.put(uint64_t(0x0102030405060708u)).put(uint32_t(0x0a0b0c0d)).put(uint16_t(0x0e0f));
+
+    uint8_t native[sizeof(storage)];
+    bin::basic_buffer<bin::native_endian> nbuf(native);
+    nbuf.put(uint64_t(0x0102030405060708u)).put(uint32_t(0x0a0b0c0d)).put(uint16_t(0x0e0f));
+    ASSERT_EQ(0, std::memcmp(native, cbuf, buf.size() - buf.bytes_left()));
+
+    bin::aligned_readonly_buffer rd_buf(cbuf, sizeof(storage));
+    ASSERT_EQ(0x0102030405060708u, get<uint64_t>(rd_buf));
+    ASSERT_EQ(0x0a0b0c0du, get<uint32_t>(rd_buf));
+    ASSERT_EQ(0x0e0fu, get<uint16_t>(rd_buf));
+}
+
+namespace {
+
+template <typename ByteOrder, typename T>
+void check_array_round_trip()
+{
+    // Odd count exercises both vector blocks and scalar tail.
+    const std::size_t Count = 67;
+    T values[Count];
+    for (std::size_t i = 0; i < Count; ++i) {
+        values[i] = T(0x0102030405060708u * (i + 1));
+    }
+
+    uint8_t expected[Count * sizeof(T)];
+    bin::basic_buffer<ByteOrder> scalar(expected);
+    for (std::size_t i = 0; i < Count; ++i) scalar.put(values[i]);
+
+    uint8_t cbuf[Count * sizeof(T) + 1];
+    bin::basic_buffer<ByteOrder> buf(cbuf);
+    buf.put(uint8_t(0)).put_array(values, Count);
+    ASSERT_EQ(0u, buf.bytes_left());
+    ASSERT_EQ(0, std::memcmp(expected, cbuf + 1, sizeof(expected)));
+
+    T decoded[Count];
+    buf.reset().skip(1).get_array(decoded, Count);
+    ASSERT_EQ(0, std::memcmp(values, decoded, sizeof(values)));
+    ASSERT_THROW(buf.reset().skip(2).get_array(decoded, Count), std::out_of_range);
+}
+
+}
+
+TEST(Buffer, array_round_trip)
+{
+    check_array_round_trip<bin::big_endian, uint8_t>();
+    check_array_round_trip<bin::big_endian, int8_t>();
+    check_array_round_trip<bin::big_endian, uint16_t>();
+    check_array_round_trip<bin::big_endian, uint32_t>();
+    check_array_round_trip<bin::big_endian, uint64_t>();
+    check_array_round_trip<bin::little_endian, uint8_t>();
+    check_array_round_trip<bin::little_endian, int8_t>();
+    check_array_round_trip<bin::little_endian, uint16_t>();
+    check_array_round_trip<bin::little_endian, uint32_t>();
+    check_array_round_trip<bin::little_endian, uint64_t>();
+    check_array_round_trip<bin::native_endian, uint8_t>();
+    check_array_round_trip<bin::native_endian, int8_t>();
+    check_array_round_trip<bin::native_endian, uint32_t>();
+}
+
+TEST(Buffer, floating_point_array_round_trip)
+{
+    const float floats[] = {1.5f, -0.25f, 3e10f, 0.0f, -1e-20f};
+    const double doubles[] = {-2.5, 1e300, 0.1};
+    uint8_t cbuf[sizeof(floats) + sizeof(doubles)];
+    bin::buffer buf(cbuf);
+    buf.put_array(floats, 5).put_array(doubles, 3);
+
+    float f;
+    double d;
+    buf.reset().get(f);
+    ASSERT_EQ(floats[0], f);
+    buf.skip(4 * sizeof(float)).get(d);
+    ASSERT_EQ(doubles[0], d);
+
+    float r_floats[5];
+    double r_doubles[3];
+    buf.reset().get_array(r_floats, 5).get_array(r_doubles, 3);
+    ASSERT_EQ(0, std::memcmp(floats, r_floats, sizeof(floats)));
+    ASSERT_EQ(0, std::memcmp(doubles, r_doubles, sizeof(doubles)));
+}
+
+TEST(Buffer, signed_and_floating_point_values)
+{
+    const uint8_t Expected[] = {
+        0xff,
+        0xff, 0xfe,
+        0xff, 0xff, 0xff, 0xfd,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfc,
+        0x3f, 0xc0, 0x00, 0x00,
+        0xc0, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+    uint8_t cbuf[sizeof(Expected)];
+    bin::buffer buf(cbuf);
+    buf.put(int8_t(-1)).put(int16_t(-2)).put(int32_t(-3)).put(int64_t(-4))
+        .put(1.5f).put(-2.5);
+    ASSERT_EQ(0u, buf.bytes_left());
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(cbuf)));
+
+    buf.reset();
+    ASSERT_EQ(-1, get<int8_t>(buf));
+    ASSERT_EQ(-2, get<int16_t>(buf));
+    ASSERT_EQ(-3, get<int32_t>(buf));
+    ASSERT_EQ(-4, get<int64_t>(buf));
+    ASSERT_EQ(1.5f, get<float>(buf));
+    ASSERT_EQ(-2.5, get<double>(buf));
+
+    bin::le_buffer le(cbuf);
+    le.put(-2.5).put(int32_t(-3)).reset();
+    ASSERT_EQ(-2.5, get<double>(le));
+    ASSERT_EQ(-3, get<int32_t>(le));
+}
+
+TEST(Buffer, array_round_trip_on_every_cpu_level)
+{
+    const bin::cpu_level detected = bin::detected_cpu_level();
+    for (int level = bin::cpu_level_scalar; level <= detected; ++level) {
+        ASSERT_EQ(level, bin::force_cpu_level(bin::cpu_level(level)));
+        check_array_round_trip<bin::big_endian, uint8_t>();
+    check_array_round_trip<bin::big_endian, int8_t>();
+    check_array_round_trip<bin::big_endian, uint16_t>();
+        check_array_round_trip<bin::big_endian, uint32_t>();
+        check_array_round_trip<bin::big_endian, uint64_t>();
+    }
+    ASSERT_EQ(detected, bin::force_cpu_level(bin::cpu_level_avx512));
+    ASSERT_EQ(detected, bin::active_cpu_level());
+}
+
+TEST(StaticBuffer, supports_arrays)
+{
+    const uint16_t values[] = {0x0102, 0x0304, 0x0506};
+    const uint8_t expected[] = {0x1, 0x2, 0x3, 0x4, 0x5, 0x6};
+    uint8_t cbuf[sizeof(expected)];
+
+    bin::static_buffer<sizeof(cbuf)> buf(cbuf);
+    ASSERT_EQ(0u, buf.put_array<3>(values).bytes_left());
+    ASSERT_EQ(0, std::memcmp(expected, cbuf, sizeof(cbuf)));
+
+    uint16_t decoded[3];
+    buf.get_array<3>(decoded);
+    ASSERT_EQ(0, std::memcmp(values, decoded, sizeof(values)));
+}
+
+TEST(Buffer, odd_width_integers)
+{
+    const uint8_t BigEndian[] = {
+        0x01, 0x02, 0x03,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06
+    };
+    const uint8_t LittleEndian[] = {
+        0x03, 0x02, 0x01,
+        0x06, 0x05, 0x04, 0x03, 0x02, 0x01
+    };
+    uint8_t cbuf[sizeof(BigEndian)];
+
+    bin::buffer be(cbuf);
+    be.put(bin::uint24_t(0x010203)).put(bin::uint48_t(0x010203040506u));
+    ASSERT_EQ(0u, be.bytes_left());
+    ASSERT_EQ(0, std::memcmp(BigEndian, cbuf, sizeof(cbuf)));
+    be.reset();
+    // the first value is decoded with a wide load, the last one isn't
+    ASSERT_EQ(0x010203u, get<bin::uint24_t>(be));
+    ASSERT_EQ(0x010203040506u, get<bin::uint48_t>(be));
+
+    bin::le_buffer le(cbuf);
+    le.put(bin::uint24_t(0xff010203)).put(bin::uint48_t(0x010203040506u));
+    ASSERT_EQ(0, std::memcmp(LittleEndian, cbuf, sizeof(cbuf)));
+    le.reset();
+    ASSERT_EQ(0x010203u, get<bin::uint24_t>(le));
+    ASSERT_EQ(0x010203040506u, get<bin::uint48_t>(le));
+}
+
+TEST(StaticBuffer, odd_width_integers)
+{
+    uint8_t cbuf[3 + 5 + 7];
+    bin::static_buffer<sizeof(cbuf)> buf(cbuf);
+    ASSERT_EQ(0u,
+              buf.put(bin::uint24_t(0x010203))
+              .put(bin::uint40_t(0x0102030405u))
+              .put(bin::uint56_t(0x01020304050607u))
+              .bytes_left());
+
+    bin::uint24_t a;
+    bin::uint40_t b;
+    bin::uint56_t c;
+    buf.get(a).get(b).get(c);
+    ASSERT_EQ(0x010203u, a);
+    ASSERT_EQ(0x0102030405u, b);
+    ASSERT_EQ(0x01020304050607u, c);
+    ASSERT_EQ(3u, bin::wire_size<bin::uint24_t>::value);
+}
+
+#if ENCODING_BINARY_HAS_CONSTEXPR_ENCODING
+
+namespace {
+
+constexpr bin::byte_array<10> make_preamble()
+{
+    bin::byte_array<10> bytes = {};
+    bin::writeonly_static_buffer<10>(bytes.data)
+        .put(uint32_t(0xcafebabe))
+        .put(int16_t(-2))
+        .put(bin::uint24_t(0x010203))
+        .put(uint8_t(7));
+    return bytes;
+}
+
+constexpr uint32_t read_magic(const bin::byte_array<10> &bytes)
+{
+    uint32_t magic = 0;
+    bin::readonly_static_buffer<10>(bytes.data).get(magic);
+    return magic;
+}
+
+constexpr bin::byte_array<10> Preamble = make_preamble();
+
+}
+
+TEST(StaticBuffer, encodes_in_constant_expressions)
+{
+    static_assert(Preamble.data[0] == 0xca && Preamble.data[3] == 0xbe, "magic");
+    static_assert(Preamble.data[4] == 0xff && Preamble.data[5] == 0xfe, "version");
+    static_assert(Preamble.data[6] == 1 && Preamble.data[8] == 3, "flags");
+    static_assert(read_magic(Preamble) == 0xcafebabe, "round trip");
+
+    uint8_t cbuf[sizeof(Preamble.data) + sizeof(uint32_t)];
+    bin::writeonly_static_buffer<sizeof(cbuf)> buf(cbuf);
+    buf.put(Preamble).put(uint32_t(42));
+    ASSERT_EQ(0, std::memcmp(Preamble.data, cbuf, sizeof(Preamble.data)));
+
+    bin::writeonly_buffer dyn(cbuf);
+    dyn.put(Preamble);
+    ASSERT_EQ(sizeof(uint32_t), dyn.bytes_left());
+}
+
+#endif
+
+TEST(Buffer, network_order_is_big_endian)
+{
+    uint8_t cbuf[Total];
+    bin::network_writeonly_buffer buf(cbuf);
+    buf.put(Head).put(Middle, sizeof(Middle)).put(Tail);
+    ASSERT_EQ(0, std::memcmp(BigEndianExpected, cbuf, Total));
+
+    bin::network_readonly_buffer rd_buf(cbuf);
+    ASSERT_EQ(Head, get<uint32_t>(rd_buf));
+}
+
+TEST(Buffer, per_call_byte_order)
+{
+    const uint8_t Expected[] = {0x1, 0x2, 0x4, 0x3, 0x5, 0x6, 0x7, 0x8};
+    uint8_t cbuf[sizeof(Expected)];
+    bin::buffer buf(cbuf);
+    buf.put(uint16_t(0x0102))
+        .put<bin::little_endian>(uint16_t(0x0304))
+        .put<bin::big_endian>(uint32_t(0x05060708));
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(cbuf)));
+
+    uint16_t a, b;
+    uint32_t c;
+    buf.reset().get(a).get<bin::little_endian>(b).get<bin::big_endian>(c);
+    ASSERT_EQ(0x0102u, a);
+    ASSERT_EQ(0x0304u, b);
+    ASSERT_EQ(0x05060708u, c);
+}
+
+TEST(StaticBuffer, per_call_byte_order)
+{
+    const uint8_t Expected[] = {0x1, 0x2, 0x4, 0x3};
+    uint8_t cbuf[sizeof(Expected)];
+    bin::static_buffer<sizeof(cbuf)> buf(cbuf);
+    buf.put(uint16_t(0x0102)).put<bin::little_endian>(uint16_t(0x0304));
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(cbuf)));
+
+    uint16_t a, b;
+    buf.get<bin::little_endian>(a).get<bin::little_endian>(b);
+    ASSERT_EQ(0x0201u, a);
+    ASSERT_EQ(0x0304u, b);
+}
+
+TEST(Buffer, reserve_and_require_windows)
+{
+    uint8_t cbuf[Total];
+    bin::buffer buf(cbuf);
+    buf.reserve(sizeof(Head) + sizeof(Middle))
+        .put(Head)
+        .put(Middle, sizeof(Middle));
+    ASSERT_EQ(sizeof(Tail), buf.bytes_left());
+    buf.reserve(sizeof(Tail)).put(Tail);
+    ASSERT_EQ(0, std::memcmp(BigEndianExpected, cbuf, Total));
+    ASSERT_THROW(buf.reserve(1), std::out_of_range);
+
+    uint32_t head;
+    uint8_t middle[sizeof(Middle)];
+    buf.reset();
+    {
+        bin::basic_window<bin::default_byte_order, bin::read_write_access_tag> w =
+            buf.require(sizeof(head) + sizeof(middle));
+        w.get(head).get(middle, sizeof(middle));
+        ASSERT_EQ(0u, w.bytes_left());
+        ASSERT_EQ(Total, buf.bytes_left());
+    }
+    ASSERT_EQ(Head, head);
+    ASSERT_EQ(0, std::memcmp(Middle, middle, sizeof(Middle)));
+    ASSERT_EQ(sizeof(Tail), buf.bytes_left());
+    ASSERT_THROW(buf.require(sizeof(Tail) + 1), std::out_of_range);
+}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+TEST(Buffer, moved_window_commits_once)
+{
+    typedef bin::basic_window<bin::default_byte_order, bin::read_write_access_tag> window;
+    uint8_t cbuf[16] = {0};
+    bin::buffer buf(cbuf);
+    {
+        window first = buf.reserve(8);
+        first.put(uint32_t(1));
+        window second(std::move(first));
+        second.put(uint16_t(2));
+    }
+    ASSERT_EQ(6u, buf.pos() - buf.begin());
+
+    uint8_t other_cbuf[4] = {0};
+    bin::buffer other(other_cbuf);
+    {
+        window first = buf.reserve(4);
+        first.put(uint8_t(3));
+        window second = other.reserve(4);
+        second.put(uint8_t(4));
+        first = std::move(second);
+        ASSERT_EQ(7u, buf.pos() - buf.begin());
+        first.put(uint8_t(5));
+    }
+    ASSERT_EQ(7u, buf.pos() - buf.begin());
+    ASSERT_EQ(2u, other.pos() - other.begin());
+}
+#endif
+
+TEST(Buffer, sticky_overflow_is_checked_once)
+{
+    uint8_t cbuf[Total];
+    bin::basic_buffer<bin::default_byte_order,
+                      bin::read_write_access_tag,
+                      bin::sticky_overflow> buf(cbuf);
+    buf.put(Head).put(uint64_t(0)).put(Tail);
+    ASSERT_TRUE(buf.overflowed());
+    ASSERT_EQ(0u, buf.bytes_left());
+
+    buf.clear_overflow();
+    buf.reset().put(Head).put(Middle, sizeof(Middle)).put(Tail);
+    ASSERT_FALSE(buf.overflowed());
+    ASSERT_EQ(0, std::memcmp(BigEndianExpected, cbuf, Total));
+
+    uint32_t head = 0;
+    uint64_t big = 7;
+    buf.reset().get(head).get(big);
+    ASSERT_TRUE(buf.overflowed());
+    ASSERT_EQ(Head, head);
+    ASSERT_EQ(7u, big);
+}
+
+TEST(BufferDeathTest, abort_on_overflow)
+{
+    uint8_t cbuf[1];
+    bin::basic_buffer<bin::default_byte_order,
+                      bin::write_access_tag,
+                      bin::abort_on_overflow> buf(cbuf);
+    ASSERT_DEATH(buf.put(uint16_t(1)), "");
+}
+
+TEST(Buffer, put_large_sequence)
+{
+    const std::size_t Length = ENCODING_BINARY_STREAMING_THRESHOLD + 77;
+    std::vector<uint8_t> payload(Length);
+    for (std::size_t i = 0; i < Length; ++i) payload[i] = uint8_t(i * 31);
+    std::vector<uint8_t> storage(Length + 3);
+
+    bin::writeonly_buffer buf(&storage[0], storage.size());
+    buf.put(uint8_t(0xff)).put(&payload[0], Length);
+    ASSERT_EQ(2u, buf.bytes_left());
+    ASSERT_EQ(0, std::memcmp(&payload[0], &storage[1], Length));
+    ASSERT_THROW(buf.put(&payload[0], 3), std::out_of_range);
+    ASSERT_EQ(2u, buf.bytes_left());
+}
+
+TEST(Buffer, blobs_are_read_without_copying)
+{
+    const uint8_t Name[] = {'b', 'l', 'o', 'b'};
+    uint8_t cbuf[32];
+    bin::buffer buf(cbuf);
+    buf.put_blob<uint16_t>(Name, sizeof(Name))
+        .put_blob<bin::varint_prefix>(Name, 3)
+        .put_blob<uint8_t>(Name, 0);
+    const uint8_t Expected[] = {0, 4, 'b', 'l', 'o', 'b', 3, 'b', 'l', 'o', 0};
+    ASSERT_EQ(sizeof(Expected), buf.size() - buf.bytes_left());
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+
+    bin::byte_view first, second, third;
+    buf.reset().get_blob<uint16_t>(first).get_blob<bin::varint_prefix>(second)
+        .get_blob<uint8_t>(third);
+    ASSERT_EQ(cbuf + 2, first.data());
+    ASSERT_TRUE(first == bin::byte_view(Name, sizeof(Name)));
+    ASSERT_TRUE(second == bin::byte_view(Name, 3));
+    ASSERT_TRUE(third.empty());
+
+    std::vector<uint8_t> big(300);
+    ASSERT_THROW(buf.reset().put_blob<uint8_t>(&big[0], big.size()), std::out_of_range);
+    ASSERT_THROW(buf.reset().put_blob<uint8_t>(Name, sizeof(cbuf)), std::out_of_range);
+    ASSERT_EQ(sizeof(cbuf), buf.bytes_left());
+
+    const uint8_t Truncated[] = {0, 5, 'b', 'l', 'o', 'b'};
+    bin::readonly_buffer rd(Truncated);
+    ASSERT_THROW(rd.get_blob<uint16_t>(first), std::out_of_range);
+
+    typedef bin::basic_buffer<bin::big_endian, bin::read_access_tag, bin::sticky_overflow> sticky_buffer;
+    const uint8_t ShortPrefix[] = {0};
+    const uint8_t ShortVarint[] = {0x80};
+    sticky_buffer short_prefix(ShortPrefix);
+    short_prefix.get_blob<uint16_t>(first);
+    sticky_buffer short_varint(ShortVarint);
+    short_varint.get_blob<bin::varint_prefix>(first);
+    sticky_buffer short_payload(Truncated);
+    short_payload.get_blob<uint16_t>(first);
+    ASSERT_TRUE(short_prefix.overflowed() && short_varint.overflowed() && short_payload.overflowed());
+    ASSERT_EQ(cbuf + 2, first.data());
+    ASSERT_EQ(sizeof(Name), first.size());
+}
+
+TEST(Buffer, slices_bound_nested_decoders)
+{
+    uint8_t cbuf[Total];
+    bin::buffer wr(cbuf);
+    wr.put(Head).put(Middle, sizeof(Middle)).put(Tail);
+
+    bin::readonly_buffer rd(cbuf);
+    bin::readonly_buffer head = rd.slice(sizeof(Head));
+    ASSERT_EQ(sizeof(Head), head.size());
+    ASSERT_EQ(Total - sizeof(Head), rd.bytes_left());
+    ASSERT_EQ(Head, get<uint32_t>(head));
+    ASSERT_THROW(get<uint8_t>(head), std::out_of_range);
+
+    bin::readonly_static_buffer<sizeof(Middle)> middle = rd.slice<sizeof(Middle)>();
+    uint8_t first;
+    middle.get(first);
+    ASSERT_EQ(Middle[0], first);
+    ASSERT_EQ(sizeof(Tail), rd.bytes_left());
+    ASSERT_THROW(rd.slice(sizeof(Tail) + 1), std::out_of_range);
+}
+
+TEST(StaticBuffer, slice_splits_at_compile_time)
+{
+    uint8_t cbuf[Total];
+    bin::static_buffer<Total> buf(cbuf);
+    buf.put(Head).put<sizeof(Middle)>(Middle).put(Tail);
+
+    bin::readonly_static_buffer<Total> rd(cbuf);
+    uint32_t head;
+    uint16_t tail;
+    rd.get(head).slice<sizeof(Middle)>().second.get(tail);
+    ASSERT_EQ(Head, head);
+    ASSERT_EQ(Tail, tail);
+
+    uint8_t last;
+    rd.skip<sizeof(Head)>().slice<sizeof(Middle)>().first.skip<3>().get(last);
+    ASSERT_EQ(Middle[3], last);
+}
+
+TEST(Buffer, peek_and_read_at_keep_position)
+{
+    uint8_t cbuf[Total];
+    bin::buffer buf(cbuf);
+    buf.put(Head).put(Middle, sizeof(Middle)).put(Tail);
+    buf.reset().skip(sizeof(Head));
+
+    ASSERT_EQ(Middle[0], buf.peek<uint8_t>());
+    ASSERT_EQ(Head, buf.read_at<uint32_t>(0));
+    ASSERT_EQ(Tail, buf.read_at<uint16_t>(Total - sizeof(Tail)));
+    ASSERT_EQ(Total - sizeof(Head), buf.bytes_left());
+    ASSERT_THROW(buf.read_at<uint32_t>(Total - 2), std::out_of_range);
+    ASSERT_THROW(buf.read_at<uint8_t>(Total + 1), std::out_of_range);
+
+    bin::readonly_static_buffer<Total> rd(cbuf);
+    ASSERT_EQ(Head, rd.peek<uint32_t>());
+    ASSERT_EQ(Tail, (rd.read_at<uint16_t, Total - sizeof(Tail)>()));
+    ASSERT_EQ(Middle[1], rd.skip<sizeof(Head) + 1>().peek<uint8_t>());
+}
+
+TEST(Buffer, placeholders_are_filled_in_place)
+{
+    uint8_t cbuf[16];
+    bin::buffer buf(cbuf);
+    bin::placeholder<uint16_t> outer = buf.put_placeholder<uint16_t>();
+    bin::placeholder<uint8_t> inner = buf.put_placeholder<uint8_t>();
+    buf.put(Head);
+    buf.fill_length(inner).put(Tail).fill_length(outer);
+    ASSERT_EQ(9, buf.pos() - buf.begin());
+
+    const uint8_t Expected[] = {0, 7, 4, 1, 2, 3, 4, 9, 10};
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+    buf.fill(inner, uint8_t(0xff));
+    ASSERT_EQ(0xff, cbuf[2]);
+
+    bin::placeholder<uint32_t> beyond = { 6 };
+    ASSERT_THROW(buf.fill(beyond, 0u), std::out_of_range);
+    buf.put(uint32_t(0)).put(uint16_t(0)).put(uint8_t(0));
+    bin::placeholder<uint8_t> small = { 0 };
+    ASSERT_NO_THROW(buf.fill_length(small));
+    ASSERT_EQ(15, cbuf[0]);
+}
+
+TEST(Buffer, packed_length_placeholders)
+{
+    uint8_t cbuf[8];
+    bin::buffer buf(cbuf);
+    bin::placeholder<bin::uint24_t> length = buf.put_placeholder<bin::uint24_t>();
+    buf.put(Head).fill_length(length);
+    const uint8_t Expected[] = {0, 0, 4, 1, 2, 3, 4};
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+
+    const uint8_t Payload[] = {5, 6};
+    bin::readonly_buffer rd(cbuf);
+    bin::byte_view view;
+    buf.reset().put_blob<bin::uint24_t>(Payload, sizeof(Payload));
+    rd.get_blob<bin::uint24_t>(view);
+    ASSERT_TRUE(view == bin::byte_view(Payload, sizeof(Payload)));
+}
+
+TEST(Buffer, cursors_are_assignable_and_resumable)
+{
+    uint8_t cbuf[Total];
+    bin::buffer buf(cbuf);
+    buf.put(Head).put(Middle, sizeof(Middle)).put(Tail);
+
+    // A decoder that ran out of input saves its mark and resumes on a
+    // larger range with the same contents.
+    bin::readonly_buffer rd(cbuf, sizeof(Head) + 2);
+    uint32_t head = 0;
+    rd.get(head);
+    const std::size_t mark = rd.mark();
+    ASSERT_EQ(sizeof(Head), mark);
+    ASSERT_THROW(bin::get<uint32_t>(rd), std::out_of_range);
+
+    std::vector<bin::readonly_buffer> cursors(2, bin::readonly_buffer(cbuf, std::size_t(0)));
+    cursors[0] = rd;
+    cursors[0].assign(cbuf, Total).restore(mark);
+    uint8_t middle[sizeof(Middle)];
+    cursors[0].get(middle, sizeof(middle));
+    ASSERT_EQ(0, std::memcmp(Middle, middle, sizeof(Middle)));
+    ASSERT_EQ(Tail, bin::get<uint16_t>(cursors[0]));
+    ASSERT_THROW(cursors[0].restore(Total + 1), std::out_of_range);
+
+    bin::readonly_static_buffer<Total> static_rd(cbuf);
+    static_rd = bin::readonly_static_buffer<Total>(cbuf + 0);
+    ASSERT_EQ(Head, static_rd.peek<uint32_t>());
+}
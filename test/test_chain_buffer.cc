@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/chain_buffer.h"
+#include <cstring>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+std::vector<uint8_t> gather(bin::chain_buffer &buf)
+{
+    std::vector<uint8_t> bytes;
+    const bin::io_slice *slices = buf.slices();
+    for (std::size_t i = 0; i < buf.chunk_count(); ++i) {
+        const uint8_t *base = static_cast<const uint8_t*>(slices[i].iov_base);
+        bytes.insert(bytes.end(), base, base + slices[i].iov_len);
+    }
+    return bytes;
+}
+
+}
+
+TEST(ChainBuffer, values_straddle_chunks)
+{
+    ASSERT_THROW(bin::chunk_pool(0), std::invalid_argument);
+
+    bin::chunk_pool pool(5);
+    bin::chain_buffer buf(pool);
+    buf.put(uint32_t(0x01020304)).put(uint32_t(0x05060708)).put(uint16_t(0x090a))
+        .put_varint(uint32_t(300));
+    ASSERT_EQ(12u, buf.size());
+    ASSERT_EQ(3u, buf.chunk_count());
+
+    const uint8_t Expected[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xac, 0x02};
+    const std::vector<uint8_t> bytes = gather(buf);
+    ASSERT_EQ(sizeof(Expected), bytes.size());
+    ASSERT_EQ(0, std::memcmp(Expected, &bytes[0], sizeof(Expected)));
+    ASSERT_EQ(5u, buf.slices()[0].iov_len);
+    ASSERT_EQ(2u, buf.slices()[2].iov_len);
+}
+
+TEST(ChainBuffer, large_payloads_and_chunk_reuse)
+{
+    bin::chunk_pool pool(64);
+    std::vector<uint16_t> values(1000);
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = uint16_t(i);
+    {
+        bin::chain_buffer buf(pool);
+        buf.put(uint8_t(0xff)).put_array(&values[0], values.size());
+        ASSERT_EQ(2001u, buf.size());
+        const std::vector<uint8_t> bytes = gather(buf);
+        ASSERT_EQ(2001u, bytes.size());
+        bin::readonly_buffer rd(&bytes[0], bytes.size());
+        rd.skip(1);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(values[i], bin::get<uint16_t>(rd));
+        }
+        buf.clear();
+        ASSERT_EQ(0u, buf.size());
+        buf.put(values[1]);
+        ASSERT_EQ(1u, buf.chunk_count());
+    }
+    bin::chain_buffer again(pool);
+    again.put(&std::vector<uint8_t>(200, 7)[0], 200);
+    ASSERT_EQ(4u, again.chunk_count());
+    ASSERT_EQ(200u, again.size());
+}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+TEST(ChainBuffer, moves_chunks)
+{
+    bin::chunk_pool pool(4);
+    bin::chain_buffer buf(pool);
+    buf.put(uint32_t(0x01020304)).put(uint16_t(0x0506));
+    bin::chain_buffer moved(std::move(buf));
+    ASSERT_EQ(0u, buf.size());
+    ASSERT_EQ(0u, buf.chunk_count());
+    ASSERT_EQ(6u, moved.size());
+    moved.put(uint16_t(0x0708));
+
+    bin::chunk_pool other_pool(16);
+    bin::chain_buffer target(other_pool);
+    target.put(uint8_t(0xff));
+    target = std::move(moved);
+    ASSERT_EQ(8u, target.size());
+    ASSERT_EQ(0u, moved.size());
+    const uint8_t Expected[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    const std::vector<uint8_t> bytes = gather(target);
+    ASSERT_EQ(0, std::memcmp(Expected, &bytes[0], sizeof(Expected)));
+
+    buf.put(uint8_t(9));
+    ASSERT_EQ(1u, buf.size());
+}
+#endif
+
+TEST(ChainBuffer, placeholders_straddle_chunks)
+{
+    bin::chunk_pool pool(4);
+    bin::chain_buffer buf(pool);
+    buf.put(uint16_t(0x0102)).put(uint8_t(3));
+    bin::placeholder<uint32_t> length = buf.put_placeholder<uint32_t>();
+    bin::placeholder<uint16_t> checksum = buf.put_placeholder<uint16_t>();
+    buf.put(uint32_t(0x0a0b0c0d));
+    buf.fill_length(length).fill(checksum, uint16_t(0xbeef));
+
+    const uint8_t Expected[] = {1, 2, 3, 0, 0, 0, 6, 0xbe, 0xef, 0x0a, 0x0b, 0x0c, 0x0d};
+    const std::vector<uint8_t> bytes = gather(buf);
+    ASSERT_EQ(sizeof(Expected), bytes.size());
+    ASSERT_EQ(0, std::memcmp(Expected, &bytes[0], sizeof(Expected)));
+    bin::placeholder<uint32_t> beyond = { 10 };
+    ASSERT_THROW(buf.fill(beyond, 0u), std::out_of_range);
+}
@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/counting_buffer.h"
+#include "encoding/binary/dynamic_buffer.h"
+#include "encoding/binary/delta.h"
+
+namespace bin = encoding::binary;
+
+namespace {
+
+template <typename BufferType>
+void encode(BufferType &buf)
+{
+    const uint8_t Payload[] = {1, 2, 3, 4, 5};
+    const uint16_t Values[] = {7, 8, 9};
+    const uint32_t Deltas[] = {10, 5, 1000};
+    bin::byte_array<3> magic = {{0xca, 0xfe, 0x01}};
+
+    bin::placeholder<uint16_t> length = buf.template put_placeholder<uint16_t>();
+    buf.put(magic).put(uint8_t(1)).template put<bin::little_endian>(uint32_t(2)).put(3.0);
+    buf.put(Payload, sizeof(Payload)).put_array(Values, 3);
+    buf.put_varint(uint32_t(300)).put_svarint(int64_t(-1000000));
+    buf.template put_blob<bin::varint_prefix>(Payload, sizeof(Payload));
+    buf.template put_blob<uint32_t>(Payload, 2);
+    bin::put_deltas(buf, Deltas, 3);
+    buf << bin::packed_uint<uint64_t, 6>(1) << uint16_t(4);
+    buf.fill_length(length);
+}
+
+}
+
+TEST(CountingBuffer, counts_exactly_what_is_written)
+{
+    bin::counting_buffer counter;
+    encode(counter);
+
+    bin::dynamic_buffer buf;
+    encode(buf);
+    ASSERT_EQ(buf.size(), counter.size());
+    ASSERT_EQ(58u, counter.size());
+
+    counter.clear().skip(3).put_placeholder<uint32_t>();
+    ASSERT_EQ(7u, counter.size());
+}
@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/delta.h"
+#include "encoding/binary/dynamic_buffer.h"
+#include <vector>
+
+namespace bin = encoding::binary;
+
+TEST(Delta, sorted_values_take_a_byte_each)
+{
+    std::vector<uint32_t> values(1000);
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = uint32_t(1000000 + 3 * i);
+
+    bin::dynamic_buffer wr;
+    bin::put_deltas(wr, &values[0], values.size());
+    // The first value takes 3 bytes, every delta of 3 takes one.
+    ASSERT_EQ(3 + values.size() - 1, wr.size());
+
+    std::vector<uint32_t> decoded(values.size());
+    bin::readonly_buffer rd = wr.written();
+    bin::get_deltas(rd, &decoded[0], decoded.size());
+    ASSERT_EQ(0u, rd.bytes_left());
+    ASSERT_TRUE(values == decoded);
+}
+
+TEST(Delta, round_trip_with_steps_back)
+{
+    const int64_t Values[] = {5, 3, -7, -7, 100, INT64_MIN, INT64_MAX, 0, 1};
+    const std::size_t Count = sizeof(Values) / sizeof(Values[0]);
+    uint8_t cbuf[Count * 10];
+    bin::le_writeonly_buffer wr(cbuf);
+    bin::put_deltas(wr, Values, Count);
+
+    int64_t decoded[Count];
+    bin::le_readonly_buffer rd(cbuf, wr.size() - wr.bytes_left());
+    bin::get_deltas(rd, decoded, Count);
+    for (std::size_t i = 0; i < Count; ++i) ASSERT_EQ(Values[i], decoded[i]) << i;
+}
+
+TEST(Delta, truncated_stream_leaves_the_rest_untouched)
+{
+    const uint32_t Values[] = {10, 20, 30, 40};
+    uint8_t cbuf[16];
+    bin::writeonly_buffer wr(cbuf);
+    bin::put_deltas(wr, Values, 4);
+
+    // The last delta is cut off.
+    bin::basic_buffer<bin::big_endian, bin::read_access_tag, bin::sticky_overflow> rd(cbuf, 3);
+    uint32_t decoded[4] = {7, 7, 7, 7};
+    bin::get_deltas(rd, decoded, 4);
+    ASSERT_TRUE(rd.overflowed());
+    ASSERT_EQ(10u, decoded[0]);
+    ASSERT_EQ(20u, decoded[1]);
+    ASSERT_EQ(30u, decoded[2]);
+    ASSERT_EQ(7u, decoded[3]);
+
+    uint32_t untouched[2] = {7, 7};
+    bin::get_deltas(rd, untouched, 2);
+    ASSERT_EQ(7u, untouched[0]);
+    ASSERT_EQ(7u, untouched[1]);
+}
+
+TEST(Delta, prefix_sum_matches_scalar)
+{
+    for (int level = bin::cpu_level_scalar; level <= bin::detected_cpu_level(); ++level) {
+        bin::force_cpu_level(bin::cpu_level(level));
+        std::vector<uint32_t> values(37), expected(37);
+        for (std::size_t i = 0; i < values.size(); ++i) values[i] = expected[i] = uint32_t(i * i + 1);
+        bin::details::prefix_sum_scalar(&expected[0], expected.size(), 10u);
+        ASSERT_EQ(expected.back(), bin::details::prefix_sum(&values[0], values.size(), 10u));
+        ASSERT_TRUE(values == expected) << bin::cpu_level_name(bin::active_cpu_level());
+    }
+    bin::force_cpu_level(bin::detected_cpu_level());
+}
@@ -0,0 +1,187 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/dynamic_buffer.h"
+#include <cstring>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+    std::size_t Allocated = 0;
+    std::size_t Allocations = 0;
+
+    template <typename T>
+    struct counting_allocator : std::allocator<T> {
+        template <typename U> struct rebind { typedef counting_allocator<U> other; };
+
+        T *allocate(std::size_t n)
+        {
+            Allocated += n;
+            ++Allocations;
+            return std::allocator<T>::allocate(n);
+        }
+
+        void deallocate(T *p, std::size_t n)
+        {
+            Allocated -= n;
+            std::allocator<T>::deallocate(p, n);
+        }
+    };
+
+    typedef bin::basic_dynamic_buffer<
+        bin::big_endian, 16, counting_allocator<uint8_t> > small_buffer;
+}
+
+TEST(DynamicBuffer, small_messages_stay_inline)
+{
+    bin::dynamic_buffer buf;
+    buf.put(uint32_t(0x01020304)).put(uint16_t(0x0506));
+    const uint8_t Expected[] = {1, 2, 3, 4, 5, 6};
+    ASSERT_TRUE(buf.is_inline());
+    ASSERT_EQ(sizeof(Expected), buf.size());
+    ASSERT_EQ(0, std::memcmp(Expected, buf.data(), buf.size()));
+
+    bin::readonly_buffer rd = buf.written();
+    uint32_t head;
+    rd.get(head);
+    ASSERT_EQ(0x01020304u, head);
+}
+
+TEST(DynamicBuffer, grows_geometrically)
+{
+    {
+        small_buffer buf;
+        for (uint32_t i = 0; i < 100; ++i) buf.put(i);
+        ASSERT_FALSE(buf.is_inline());
+        ASSERT_EQ(400u, buf.size());
+        ASSERT_EQ(512u, buf.capacity());
+        ASSERT_EQ(512u, Allocated);
+
+        bin::readonly_buffer rd = buf.written();
+        for (uint32_t i = 0; i < 100; ++i) {
+            uint32_t value;
+            rd.get(value);
+            ASSERT_EQ(i, value);
+        }
+    }
+    ASSERT_EQ(0u, Allocated);
+}
+
+TEST(DynamicBuffer, reserve_and_release)
+{
+    small_buffer buf;
+    const uint8_t Payload[20] = {1, 2, 3};
+    buf.reserve(sizeof(Payload) + 2)
+        .put(uint16_t(sizeof(Payload)))
+        .put(Payload, sizeof(Payload));
+    ASSERT_EQ(22u, buf.size());
+
+    bin::dynamic_storage storage = buf.release();
+    ASSERT_EQ(0u, buf.size());
+    ASSERT_TRUE(buf.is_inline());
+    ASSERT_EQ(22u, storage.size);
+    ASSERT_EQ(0, storage.data[0]);
+    ASSERT_EQ(20, storage.data[1]);
+    ASSERT_EQ(0, std::memcmp(Payload, storage.data + 2, sizeof(Payload)));
+    buf.get_allocator().deallocate(storage.data, storage.capacity);
+    ASSERT_EQ(0u, Allocated);
+}
+
+TEST(DynamicBuffer, release_of_empty_buffer_allocates_nothing)
+{
+    const std::size_t allocations = Allocations;
+    small_buffer buf;
+    bin::dynamic_storage storage = buf.release();
+    ASSERT_EQ(allocations, Allocations);
+    ASSERT_TRUE(storage.data == 0);
+    ASSERT_EQ(0u, storage.size);
+    ASSERT_EQ(0u, storage.capacity);
+    ASSERT_EQ(0u, Allocated);
+    ASSERT_TRUE(buf.is_inline());
+}
+
+TEST(DynamicBuffer, growth_past_max_size_throws)
+{
+    small_buffer buf;
+    buf.put(uint32_t(1));
+    ASSERT_THROW(buf.ensure(std::size_t(-1)), std::length_error);
+    ASSERT_THROW(buf.ensure(buf.max_size()), std::length_error);
+    const uint64_t value = 0;
+    ASSERT_THROW(buf.put_array(&value, std::size_t(-1) / 4), std::length_error);
+    ASSERT_EQ(4u, buf.size());
+    ASSERT_TRUE(buf.is_inline());
+}
+
+TEST(DynamicBuffer, without_inline_storage)
+{
+    {
+        bin::basic_dynamic_buffer<bin::big_endian, 0, counting_allocator<uint8_t> > buf;
+        ASSERT_EQ(0u, buf.capacity());
+        buf.put(uint16_t(0x0102));
+        ASSERT_FALSE(buf.is_inline());
+        ASSERT_EQ(2u, buf.size());
+        ASSERT_EQ(1, buf.data()[0]);
+    }
+    ASSERT_EQ(0u, Allocated);
+}
+
+TEST(DynamicBuffer, placeholders_survive_growth)
+{
+    {
+        small_buffer buf;
+        bin::placeholder<uint32_t> length = buf.put_placeholder<uint32_t>();
+        for (uint32_t i = 0; i < 100; ++i) buf.put(i);
+        ASSERT_FALSE(buf.is_inline());
+        buf.fill_length(length);
+
+        bin::readonly_buffer rd = buf.written();
+        ASSERT_EQ(400u, bin::get<uint32_t>(rd));
+        ASSERT_EQ(0u, bin::get<uint32_t>(rd));
+
+        bin::placeholder<uint8_t> byte = buf.put_placeholder<uint8_t>();
+        for (int i = 0; i < 300; ++i) buf.put(uint8_t(i));
+        ASSERT_THROW(buf.fill_length(byte), std::out_of_range);
+
+        buf.clear();
+        bin::placeholder<bin::uint24_t> packed = buf.put_placeholder<bin::uint24_t>();
+        std::vector<uint8_t> big((1 << 24) - 1);
+        buf.put(&big[0], big.size()).fill_length(packed);
+        ASSERT_EQ(0xff, buf.data()[0]);
+        ASSERT_EQ(0xff, buf.data()[2]);
+        buf.put(big[0]);
+        ASSERT_THROW(buf.fill_length(packed), std::out_of_range);
+    }
+    ASSERT_EQ(0u, Allocated);
+}
+
+#if ENCODING_BINARY_HAS_RVALUE_REFERENCES
+TEST(DynamicBuffer, moves_inline_and_heap_storage)
+{
+    {
+        small_buffer inline_buf;
+        inline_buf.put(uint32_t(0x01020304));
+        small_buffer moved(std::move(inline_buf));
+        ASSERT_TRUE(moved.is_inline());
+        ASSERT_EQ(4u, moved.size());
+        ASSERT_EQ(0u, inline_buf.size());
+        moved.put(uint8_t(5));
+        const uint8_t Expected[] = {1, 2, 3, 4, 5};
+        ASSERT_EQ(0, std::memcmp(Expected, moved.data(), sizeof(Expected)));
+
+        small_buffer heap_buf;
+        for (uint32_t i = 0; i < 10; ++i) heap_buf.put(i);
+        const uint8_t *storage = heap_buf.data();
+        moved = std::move(heap_buf);
+        ASSERT_TRUE(moved.data() == storage);
+        ASSERT_EQ(40u, moved.size());
+        ASSERT_TRUE(heap_buf.is_inline());
+        ASSERT_EQ(0u, heap_buf.size());
+
+        std::vector<small_buffer> buffers;
+        buffers.push_back(std::move(moved));
+        buffers.push_back(small_buffer());
+        ASSERT_EQ(40u, buffers[0].size());
+    }
+    ASSERT_EQ(0u, Allocated);
+}
+#endif
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/segmented_buffer.h"
+#include <cstring>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+// Splits `bytes` into segments at the given offsets.
+std::vector<bin::io_slice> split(std::vector<uint8_t> &bytes, const std::size_t *cuts, std::size_t count)
+{
+    std::vector<bin::io_slice> segments;
+    std::size_t from = 0;
+    for (std::size_t i = 0; i <= count; ++i) {
+        const std::size_t to = i < count ? cuts[i] : bytes.size();
+        bin::io_slice slice;
+        slice.iov_base = &bytes[0] + from;
+        slice.iov_len = to - from;
+        segments.push_back(slice);
+        from = to;
+    }
+    return segments;
+}
+
+}
+
+TEST(SegmentedBuffer, values_straddle_segments)
+{
+    std::vector<uint8_t> bytes(64);
+    bin::buffer out(&bytes[0], bytes.size());
+    out.put(uint32_t(0x01020304)).put(uint64_t(0x05060708090a0b0cULL)).put(uint16_t(0x0d0e))
+        .put_varint(uint64_t(1) << 60).put_svarint(int32_t(-3));
+    bytes.resize(out.pos() - out.begin());
+
+    const std::size_t Cuts[] = {2, 2, 7, 15, 17};
+    std::vector<bin::io_slice> segments = split(bytes, Cuts, 5);
+    bin::segmented_buffer in(&segments[0], segments.size());
+    ASSERT_EQ(bytes.size(), in.bytes_left());
+
+    uint32_t a; uint64_t b; uint16_t c; uint64_t d; int32_t e;
+    in.get(a).get(b).get(c).get_varint(d).get_svarint(e);
+    ASSERT_EQ(0x01020304u, a);
+    ASSERT_EQ(0x05060708090a0b0cULL, b);
+    ASSERT_EQ(0x0d0e, c);
+    ASSERT_EQ(uint64_t(1) << 60, d);
+    ASSERT_EQ(-3, e);
+    ASSERT_EQ(0u, in.bytes_left());
+}
+
+TEST(SegmentedBuffer, empty_segments)
+{
+    // Separate allocations, so that reading past a segment is caught
+    // by sanitizers instead of landing on the next one.
+    std::vector<uint8_t> first(2, 0x01);
+    std::vector<uint8_t> second(2, 0x02);
+    std::vector<uint8_t> third(3, 0x03);
+    bin::io_slice segments[] = {
+        {0, 0},
+        {&first[0], first.size()},
+        {0, 0},
+        {0, 0},
+        {&second[0], second.size()},
+        {0, 0},
+        {&third[0], third.size()},
+    };
+    bin::segmented_buffer in(segments, 7);
+    ASSERT_EQ(7u, in.bytes_left());
+
+    uint32_t a;
+    in.get(a);
+    ASSERT_EQ(0x01010202u, a);
+    ASSERT_EQ(3u, in.bytes_left());
+
+    uint8_t rest[3];
+    in.get(rest, 3);
+    ASSERT_EQ(0x03, rest[2]);
+    ASSERT_EQ(0u, in.bytes_left());
+}
+
+TEST(SegmentedBuffer, arrays_bytes_and_skip)
+{
+    std::vector<uint8_t> bytes;
+    for (std::size_t i = 0; i < 40; ++i) bytes.push_back(uint8_t(i));
+    const std::size_t Cuts[] = {3, 13, 14, 29};
+    std::vector<bin::io_slice> segments = split(bytes, Cuts, 4);
+    bin::le_segmented_buffer in(&segments[0], segments.size());
+
+    uint16_t values[10];
+    in.skip(1).get_array(values, 10);
+    for (std::size_t i = 0; i < 10; ++i) {
+        ASSERT_EQ(uint16_t((2 * i + 1) | (2 * i + 2) << 8), values[i]);
+    }
+    uint8_t rest[10];
+    in.skip(9).get(rest, 10);
+    for (std::size_t i = 0; i < 10; ++i) ASSERT_EQ(30 + i, rest[i]);
+    ASSERT_EQ(0u, in.bytes_left());
+}
+
+TEST(SegmentedBuffer, overflow)
+{
+    std::vector<uint8_t> bytes(6, 0x80);
+    const std::size_t Cuts[] = {4};
+    std::vector<bin::io_slice> segments = split(bytes, Cuts, 1);
+
+    bin::basic_segmented_buffer<bin::big_endian, bin::sticky_overflow> in(&segments[0], segments.size());
+    uint32_t value;
+    in.get(value);
+    ASSERT_FALSE(in.overflowed());
+    in.get(value);
+    ASSERT_TRUE(in.overflowed());
+    ASSERT_EQ(0u, in.bytes_left());
+
+    bin::basic_segmented_buffer<bin::big_endian, bin::sticky_overflow> partial(&segments[0], segments.size());
+    int64_t signed_value = 42;
+    partial.get_svarint(signed_value);
+    ASSERT_TRUE(partial.overflowed());
+    ASSERT_EQ(42, signed_value);
+
+    bin::segmented_buffer truncated(&segments[0], segments.size());
+    uint64_t varint;
+    ASSERT_THROW(truncated.get_varint(varint), std::out_of_range);
+}
+
+TEST(SegmentedBuffer, retarget)
+{
+    std::vector<uint8_t> bytes(4, 0);
+    bytes[3] = 7;
+    const std::size_t Cuts[] = {1};
+    std::vector<bin::io_slice> segments = split(bytes, Cuts, 1);
+
+    bin::segmented_buffer in(&segments[0], 1);
+    ASSERT_THROW(bin::get<uint32_t>(in), std::out_of_range);
+    in.assign(&segments[0], segments.size());
+    ASSERT_EQ(7u, bin::get<uint32_t>(in));
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/stream_vbyte.h"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace bin = encoding::binary;
+
+namespace {
+
+std::vector<uint32_t> make_values(std::size_t count)
+{
+    std::vector<uint32_t> values(count);
+    uint64_t seed = 7;
+    for (std::size_t i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        values[i] = uint32_t(seed >> 32) >> (seed >> 59);
+    }
+    return values;
+}
+
+}
+
+TEST(StreamVByte, known_encoding)
+{
+    const uint32_t Values[] = {1, 0x1234, 0x123456, 0x12345678, 0xff};
+    const uint8_t Expected[] = {
+        0xe4, 0x00,
+        0x01, 0x34, 0x12, 0x56, 0x34, 0x12, 0x78, 0x56, 0x34, 0x12, 0xff
+    };
+    uint8_t cbuf[sizeof(Expected)];
+    bin::writeonly_buffer wr(cbuf);
+    bin::put_stream_vbyte(wr, Values, 5);
+    ASSERT_EQ(0u, wr.bytes_left());
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(cbuf)));
+    ASSERT_EQ(sizeof(Expected), bin::stream_vbyte_size(Values, 5));
+
+    bin::writeonly_buffer small(cbuf, sizeof(cbuf) - 1);
+    ASSERT_THROW(bin::put_stream_vbyte(small, Values, 5), std::out_of_range);
+}
+
+TEST(StreamVByte, round_trip_on_every_cpu_level)
+{
+    const std::vector<uint32_t> values = make_values(1001);
+    std::vector<uint8_t> bytes(bin::stream_vbyte_size(&values[0], values.size()));
+    bin::writeonly_buffer wr(&bytes[0], bytes.size());
+    bin::put_stream_vbyte(wr, &values[0], values.size());
+    ASSERT_EQ(0u, wr.bytes_left());
+
+    for (int level = bin::cpu_level_scalar; level <= bin::detected_cpu_level(); ++level) {
+        bin::force_cpu_level(bin::cpu_level(level));
+        std::vector<uint32_t> decoded(values.size());
+        bin::readonly_buffer rd(&bytes[0], bytes.size());
+        bin::get_stream_vbyte(rd, &decoded[0], decoded.size());
+        ASSERT_EQ(0u, rd.bytes_left());
+        ASSERT_TRUE(values == decoded) << bin::cpu_level_name(bin::active_cpu_level());
+    }
+    bin::force_cpu_level(bin::detected_cpu_level());
+
+    bin::readonly_buffer truncated(&bytes[0], bytes.size() - 1);
+    std::vector<uint32_t> decoded(values.size());
+    ASSERT_THROW(bin::get_stream_vbyte(truncated, &decoded[0], decoded.size()),
+                 std::out_of_range);
+}
+
+TEST(StreamVByte, reader_decodes_in_batches)
+{
+    const std::vector<uint32_t> values = make_values(100);
+    std::vector<uint8_t> bytes(bin::stream_vbyte_size(&values[0], values.size()) + 2);
+    bin::writeonly_buffer wr(&bytes[0], bytes.size());
+    bin::put_stream_vbyte(wr, &values[0], values.size());
+    wr.put(uint16_t(0xbeef));
+
+    bin::readonly_buffer rd(&bytes[0], bytes.size());
+    bin::stream_vbyte_reader reader(rd, values.size());
+    ASSERT_EQ(2u, rd.bytes_left());
+
+    std::vector<uint32_t> decoded;
+    decoded.push_back(reader.next());
+    uint32_t batch[7];
+    while (std::size_t n = reader.read(batch, 7)) decoded.insert(decoded.end(), batch, batch + n);
+    ASSERT_EQ(0u, reader.values_left());
+    ASSERT_TRUE(values == decoded);
+    ASSERT_EQ(0xbeef, bin::get<uint16_t>(rd));
+}
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "encoding/binary/buffer.h"
+#include "encoding/binary/dynamic_buffer.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace bin = encoding::binary;
+
+TEST(Varint, known_encodings)
+{
+    uint8_t cbuf[16];
+    bin::writeonly_buffer buf(cbuf);
+    buf.put_varint(uint32_t(1)).put_varint(uint32_t(300)).put_varint(uint64_t(0));
+    const uint8_t Expected[] = {0x01, 0xac, 0x02, 0x00};
+    ASSERT_EQ(sizeof(Expected), buf.size() - buf.bytes_left());
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+
+    bin::dynamic_buffer dyn;
+    dyn.put_varint(~uint64_t(0));
+    const uint8_t Max[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    ASSERT_EQ(sizeof(Max), dyn.size());
+    ASSERT_EQ(0, std::memcmp(Max, dyn.data(), sizeof(Max)));
+}
+
+TEST(Varint, round_trip_on_fast_and_slow_paths)
+{
+    uint8_t cbuf[64 * 10];
+    bin::buffer buf(cbuf);
+    for (unsigned shift = 0; shift < 64; ++shift) {
+        buf.put_varint((uint64_t(1) << shift) | shift);
+    }
+    bin::readonly_buffer rd(cbuf, buf.size() - buf.bytes_left());
+    for (unsigned shift = 0; shift < 64; ++shift) {
+        uint64_t value;
+        rd.get_varint(value);
+        ASSERT_EQ((uint64_t(1) << shift) | shift, value) << "shift " << shift;
+    }
+    ASSERT_EQ(0u, rd.bytes_left());
+
+    const uint32_t Values[] = {0, 127, 128, 16383, 16384, 0xffffffffu};
+    buf.reset();
+    for (std::size_t i = 0; i < 6; ++i) buf.put_varint(Values[i]);
+    bin::readonly_buffer rd32(cbuf, buf.size() - buf.bytes_left());
+    for (std::size_t i = 0; i < 6; ++i) {
+        uint32_t value;
+        rd32.get_varint(value);
+        ASSERT_EQ(Values[i], value);
+    }
+}
+
+TEST(Varint, rejects_malformed_input)
+{
+    const uint8_t TooBig[] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+    uint32_t value32;
+    bin::readonly_buffer rd(TooBig);
+    ASSERT_THROW(rd.get_varint(value32), std::invalid_argument);
+
+    uint8_t padded[16] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+    bin::readonly_buffer fast(padded);
+    ASSERT_THROW(fast.get_varint(value32), std::invalid_argument);
+
+    uint8_t long64[16];
+    std::memset(long64, 0x80, sizeof(long64));
+    uint64_t value64;
+    bin::readonly_buffer wide(long64);
+    ASSERT_THROW(wide.get_varint(value64), std::invalid_argument);
+
+    const uint8_t Truncated[] = {0x80, 0x80};
+    bin::basic_buffer<bin::default_byte_order,
+                      bin::read_access_tag,
+                      bin::sticky_overflow> sticky(Truncated);
+    sticky.get_varint(value64);
+    ASSERT_TRUE(sticky.overflowed());
+
+    bin::readonly_buffer truncated(Truncated);
+    ASSERT_THROW(truncated.get_varint(value64), std::out_of_range);
+}
+
+TEST(Varint, zigzag_signed_values)
+{
+    uint8_t cbuf[32];
+    bin::buffer buf(cbuf);
+    buf.put_svarint(int32_t(0)).put_svarint(int32_t(-1)).put_svarint(int32_t(1))
+        .put_svarint(int64_t(-64)).put_svarint(INT64_MIN);
+    const uint8_t Expected[] = {0x00, 0x01, 0x02, 0x7f};
+    ASSERT_EQ(0, std::memcmp(Expected, cbuf, sizeof(Expected)));
+
+    int32_t a, b, c;
+    int64_t d, e;
+    buf.reset().get_svarint(a).get_svarint(b).get_svarint(c).get_svarint(d).get_svarint(e);
+    ASSERT_EQ(0, a);
+    ASSERT_EQ(-1, b);
+    ASSERT_EQ(1, c);
+    ASSERT_EQ(-64, d);
+    ASSERT_EQ(INT64_MIN, e);
+}
+
+TEST(Varint, failed_svarint_leaves_value_alone)
+{
+    const uint8_t Truncated[] = {0x81};
+    bin::basic_buffer<bin::default_byte_order,
+                      bin::read_access_tag,
+                      bin::sticky_overflow> buf(Truncated);
+    int32_t value = 42;
+    buf.get_svarint(value);
+    ASSERT_TRUE(buf.overflowed());
+    ASSERT_EQ(42, value);
+}